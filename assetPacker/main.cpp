@@ -0,0 +1,138 @@
+//
+//  main.cpp
+//  assetPacker
+//
+//  Created by Lax Zhang on 2019/3/16.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+//  把 resources/ 与 shaders/ 打包成一个对齐的资源包, 供 AssetPack 在运行时 mmap.
+//  用法(在 openGL-TEST2 目录下执行): assetPacker assets.pack resources shaders
+//
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "../openGL-TEST2/header/vfs/assetPack.hpp"
+
+using namespace std;
+
+struct PackFile{
+    string name;
+    string content;
+    uint64_t hash;
+};
+
+static bool byHash(const PackFile &a, const PackFile &b){
+    if (a.hash != b.hash)
+        return a.hash < b.hash;
+    return a.name < b.name;
+}
+
+// 递归收集目录下的所有文件, name 保存为相对路径
+static void collect(const string &path, vector<PackFile> &files){
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        cout << "ERROR::ASSET_PACKER: Cannot stat " << path << endl;
+        return;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(path.c_str());
+        if (dir == NULL)
+            return;
+        vector<string> children;
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] == '.')
+                continue;
+            children.push_back(path + "/" + entry->d_name);
+        }
+        closedir(dir);
+        sort(children.begin(), children.end());
+        for (size_t i = 0; i < children.size(); i++)
+            collect(children[i], files);
+        return;
+    }
+
+    ifstream file(path.c_str(), ios::in | ios::binary);
+    stringstream stream;
+    stream << file.rdbuf();
+    PackFile packFile;
+    packFile.name = path;
+    packFile.content = stream.str();
+    packFile.hash = fnv1a64(path.c_str(), path.size());
+    files.push_back(packFile);
+}
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment){
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+int main(int argc, const char * argv[]) {
+    if (argc < 3) {
+        cout << "usage: assetPacker <output.pack> <dir|file>..." << endl;
+        return 1;
+    }
+
+    vector<PackFile> files;
+    for (int i = 2; i < argc; i++) {
+        string path = argv[i];
+        while (path.size() > 1 && path[path.size() - 1] == '/')
+            path.erase(path.size() - 1);
+        collect(path, files);
+    }
+    sort(files.begin(), files.end(), byHash);
+
+    // 先排好索引、文件名表与数据的位置
+    AssetPackHeader header;
+    memcpy(header.magic, ASSET_PACK_MAGIC, 4);
+    header.version = ASSET_PACK_VERSION;
+    header.count = (uint32_t)files.size();
+    header.alignment = ASSET_PACK_ALIGNMENT;
+    header.indexOffset = sizeof(AssetPackHeader);
+    header.namesOffset = header.indexOffset + files.size() * sizeof(AssetPackEntry);
+
+    vector<AssetPackEntry> entries(files.size());
+    string names;
+    for (size_t i = 0; i < files.size(); i++) {
+        entries[i].hash = files[i].hash;
+        entries[i].nameOffset = (uint32_t)names.size();
+        entries[i].nameLength = (uint32_t)files[i].name.size();
+        names += files[i].name;
+    }
+    uint64_t offset = alignUp(header.namesOffset + names.size(), ASSET_PACK_ALIGNMENT);
+    for (size_t i = 0; i < files.size(); i++) {
+        entries[i].offset = offset;
+        entries[i].size = files[i].content.size();
+        offset = alignUp(offset + entries[i].size, ASSET_PACK_ALIGNMENT);
+    }
+
+    ofstream out(argv[1], ios::out | ios::binary | ios::trunc);
+    if (!out) {
+        cout << "ERROR::ASSET_PACKER: Cannot write " << argv[1] << endl;
+        return 1;
+    }
+    out.write((const char *)&header, sizeof(header));
+    if (!entries.empty())
+        out.write((const char *)&entries[0], entries.size() * sizeof(AssetPackEntry));
+    out.write(names.data(), names.size());
+    string padding(ASSET_PACK_ALIGNMENT, '\0');
+    uint64_t written = header.namesOffset + names.size();
+    for (size_t i = 0; i < files.size(); i++) {
+        out.write(padding.data(), entries[i].offset - written);
+        out.write(files[i].content.data(), files[i].content.size());
+        written = entries[i].offset + entries[i].size;
+        cout << files[i].name << " (" << entries[i].size << " bytes)" << endl;
+    }
+    out.write(padding.data(), offset - written);
+    out.close();
+
+    cout << "Packed " << files.size() << " files into " << argv[1] << " (" << offset << " bytes)" << endl;
+    return 0;
+}
@@ -7,52 +7,486 @@
 //
 
 #include "FontsManager.hpp"
+#include "../vfs/assetPack.hpp"
+#include "distanceField.hpp"
+#include "../util/workerPool.hpp"
+#include "../util/hash.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <string.h>
+#include <stdio.h>
 
 using namespace std;
 
-FontsManager::FontsManager(){
+// 距离场模式下先放大这么多倍光栅化, 再降采样成距离场
+static const int SDF_UPSCALE = 4;
+// 每个线程至少分到这么多字形才值得多开线程
+static const int PRELOAD_MIN_GLYPHS_PER_THREAD = 16;
+
+FontsManager::FontsManager() : pixelSize(48), sdf(false), sdfSpread(6), pageSize(1024), maxPages(4), library(NULL), frame(0), evictions(0), metricsDirty(false), metricsBufferID(0), metricsTextureID(0), cacheDirty(true){
+}
+
+// 向下取整的整数除法(bearing 可能为负)
+static int floorDiv(int a, int b){
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
 }
 
-void FontsManager::load_fonts(char *font_path){
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft))
+int FontsManager::load_fonts(char *font_path){
+    Font font;
+    font.file = new AssetFile(font_path);
+    if (!font.file->valid()) {
+        cout << "ERROR::FREETYPE: Failed to load font" << endl;
+        delete font.file;
+        return -1;
+    }
+    font.face = NULL;
+    font.hash = fnv1a64(font.file->data(), font.file->size());
+    fonts.push_back(font);
+    return (int)fonts.size() - 1;
+}
+
+bool FontsManager::openFace(int font){
+    if (fonts[font].face != NULL)
+        return true;
+    if (library == NULL && FT_Init_FreeType(&library)) {
         cout << "ERROR::FREETYPE: Could not init FreeType Library" << endl;
-    FT_Face face;
-    if (FT_New_Face(ft, font_path, 0, &face))
+        library = NULL;
+        return false;
+    }
+    const AssetFile &file = *fonts[font].file;
+    if (FT_New_Memory_Face(library, file.data(), (FT_Long)file.size(), 0, &fonts[font].face)) {
         cout << "ERROR::FREETYPE: Failed to load font" << endl;
-    FT_Set_Pixel_Sizes(face, 0, 48); // 设置字体的宽高
-    
-    // 强制按照1bit对齐
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    // 保存128个字符
-    for (GLubyte c = 0; c < 128; c++) {
-        // 加载字体
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-            cout << "ERROR::FREETYTPE: Failed to load Glyph" << endl;
+        fonts[font].face = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool FontsManager::loadCache(const char *path){
+    if (!cache.open(path))
+        return false;
+    const FontCacheHeader &header = cache.header();
+    bool match = header.pixelSize == (uint32_t)pixelSize && header.sdf == (uint32_t)sdf &&
+                 header.sdfSpread == (uint32_t)sdfSpread && header.pageSize == (uint32_t)pageSize &&
+                 header.fontCount == fonts.size();
+    for (uint32_t i = 0; match && i < header.fontCount; i++)
+        match = cache.fontHashes()[i] == fonts[i].hash;
+    if (!match) {
+        cache.close();
+        return false;
+    }
+
+    // 恢复图集页, 像素直接引用映射内存
+    for (size_t i = 0; i < pages.size(); i++)
+        pages[i].release();
+    pages.assign(header.pageCount, GlyphAtlas());
+    pageFrames.assign(header.pageCount, frame);
+    for (uint32_t i = 0; i < header.pageCount; i++) {
+        const FontCachePage &page = cache.pages()[i];
+        vector<GlyphAtlas::Shelf> shelves(page.shelfCount);
+        for (uint32_t s = 0; s < page.shelfCount; s++) {
+            const FontCacheShelf &shelf = cache.shelves()[page.firstShelf + s];
+            shelves[s].y = shelf.y;
+            shelves[s].height = shelf.height;
+            shelves[s].x = shelf.x;
+        }
+        pages[i].restore(pageSize, pageSize, cache.pagePixels(i), shelves, page.nextY);
+    }
+    glyphs.clear();
+    resetMetrics();
+    for (uint32_t i = 0; i < header.glyphCount; i++) {
+        const FontCacheGlyph &glyph = cache.glyphs()[i];
+        Character character;
+        character.size = glm::ivec2(glyph.size[0], glyph.size[1]);
+        character.Bearing = glm::ivec2(glyph.bearing[0], glyph.bearing[1]);
+        character.Advance = (long)glyph.advance;
+        character.uvMin = glm::vec2(glyph.uvMin[0], glyph.uvMin[1]);
+        character.uvMax = glm::vec2(glyph.uvMax[0], glyph.uvMax[1]);
+        character.page = glyph.page;
+        assignIndex(character);
+        glyphs.insert(glyph.key, character);
+    }
+    cacheDirty = false;
+    return true;
+}
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment){
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool FontsManager::saveCache(const char *path){
+    if (!cacheDirty)
+        return true;
+
+    vector<FontCacheGlyph> glyphRecords;
+    glyphRecords.reserve(glyphs.size());
+    glyphs.forEach([&](uint64_t key, const Character &character){
+        FontCacheGlyph glyph;
+        memset(&glyph, 0, sizeof(glyph));
+        glyph.key = key;
+        glyph.size[0] = character.size.x;
+        glyph.size[1] = character.size.y;
+        glyph.bearing[0] = character.Bearing.x;
+        glyph.bearing[1] = character.Bearing.y;
+        glyph.advance = character.Advance;
+        glyph.uvMin[0] = character.uvMin.x;
+        glyph.uvMin[1] = character.uvMin.y;
+        glyph.uvMax[0] = character.uvMax.x;
+        glyph.uvMax[1] = character.uvMax.y;
+        glyph.page = character.page;
+        glyphRecords.push_back(glyph);
+    });
+    vector<FontCachePage> pageRecords(pages.size());
+    vector<FontCacheShelf> shelfRecords;
+    for (size_t i = 0; i < pages.size(); i++) {
+        const vector<GlyphAtlas::Shelf> &shelves = pages[i].getShelves();
+        pageRecords[i].firstShelf = (uint32_t)shelfRecords.size();
+        pageRecords[i].shelfCount = (uint32_t)shelves.size();
+        pageRecords[i].nextY = pages[i].usedHeight();
+        pageRecords[i].reserved = 0;
+        for (size_t s = 0; s < shelves.size(); s++) {
+            FontCacheShelf shelf = {shelves[s].y, shelves[s].height, shelves[s].x};
+            shelfRecords.push_back(shelf);
+        }
+    }
+    vector<uint64_t> hashes(fonts.size());
+    for (size_t i = 0; i < fonts.size(); i++)
+        hashes[i] = fonts[i].hash;
+
+    FontCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FONT_CACHE_MAGIC, 4);
+    header.version = FONT_CACHE_VERSION;
+    header.pixelSize = pixelSize;
+    header.sdf = sdf;
+    header.sdfSpread = sdfSpread;
+    header.pageSize = pageSize;
+    header.fontCount = (uint32_t)hashes.size();
+    header.glyphCount = (uint32_t)glyphRecords.size();
+    header.pageCount = (uint32_t)pageRecords.size();
+    header.shelfCount = (uint32_t)shelfRecords.size();
+    header.hashesOffset = sizeof(FontCacheHeader);
+    header.glyphsOffset = header.hashesOffset + hashes.size() * sizeof(uint64_t);
+    header.pagesOffset = header.glyphsOffset + glyphRecords.size() * sizeof(FontCacheGlyph);
+    header.shelvesOffset = header.pagesOffset + pageRecords.size() * sizeof(FontCachePage);
+    header.pixelsOffset = alignUp(header.shelvesOffset + shelfRecords.size() * sizeof(FontCacheShelf), FONT_CACHE_ALIGNMENT);
+
+    // 先写临时文件再改名, 正在映射的旧缓存不受影响
+    string temp = string(path) + ".tmp";
+    FILE *file = fopen(temp.c_str(), "wb");
+    if (file == NULL) {
+        cout << "ERROR::FONT_CACHE: Cannot write " << temp << endl;
+        return false;
+    }
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(hashes.data(), sizeof(uint64_t), hashes.size(), file);
+    fwrite(glyphRecords.data(), sizeof(FontCacheGlyph), glyphRecords.size(), file);
+    fwrite(pageRecords.data(), sizeof(FontCachePage), pageRecords.size(), file);
+    fwrite(shelfRecords.data(), sizeof(FontCacheShelf), shelfRecords.size(), file);
+    char padding[FONT_CACHE_ALIGNMENT] = {0};
+    fwrite(padding, 1, header.pixelsOffset - (header.shelvesOffset + shelfRecords.size() * sizeof(FontCacheShelf)), file);
+    for (size_t i = 0; i < pages.size(); i++)
+        fwrite(pages[i].data(), 1, (size_t)pageSize * pageSize, file);
+    bool ok = ferror(file) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temp.c_str(), path) != 0) {
+        cout << "ERROR::FONT_CACHE: Cannot write " << path << endl;
+        remove(temp.c_str());
+        return false;
+    }
+    cacheDirty = false;
+    return true;
+}
+
+void FontsManager::beginFrame(){
+    // 超出上限的页总在末尾, 刚结束的一帧没有用到就收回
+    while ((int)pages.size() > maxPages && pageFrames.back() != frame) {
+        forgetPage((int)pages.size() - 1);
+        pages.back().release();
+        pages.pop_back();
+        pageFrames.pop_back();
+    }
+    frame++;
+}
+
+uint64_t FontsManager::glyphKey(int font, int size, uint32_t codepoint){
+    return ((uint64_t)(font & 0xFFFF) << 48) | ((uint64_t)(size & 0xFFFF) << 32) | codepoint;
+}
+
+const FontsManager::Character *FontsManager::getGlyph(uint32_t codepoint, int font){
+    uint64_t key = glyphKey(font, pixelSize, codepoint);
+    Character *cached = glyphs.find(key);
+    if (cached != NULL) {
+        if (cached->page >= 0)
+            pageFrames[cached->page] = frame;
+        return cached;
+    }
+    if (font < 0 || font >= (int)fonts.size() || failedGlyphs.find(key) != NULL)
+        return NULL;
+
+    vector<unsigned char> data;
+    Character character;
+    if (!openFace(font))
+        return NULL;
+    if (!rasterize(fonts[font].face, codepoint, data, character)) {
+        cout << "ERROR::FREETYTPE: Failed to load Glyph " << codepoint << endl;
+        failedGlyphs.insert(key, 1);
+        return NULL;
+    }
+    return store(key, character, data);
+}
+
+const FontsManager::Character *FontsManager::store(uint64_t key, Character &character, const vector<unsigned char> &data){
+    // 空格等没有位图的字符不占图集空间
+    character.page = -1;
+    if (character.size.x > 0 && character.size.y > 0) {
+        glm::ivec2 pos;
+        character.page = allocate(character.size.x, character.size.y, pos);
+        if (character.page < 0) {
+            cout << "ERROR::FREETYPE: Glyph " << (uint32_t)key << " does not fit into an atlas page" << endl;
+            failedGlyphs.insert(key, 1);
+            return NULL;
+        }
+        GlyphAtlas &atlas = pages[character.page];
+        atlas.blit(&data[0], character.size.x, character.size.y, character.size.x, pos);
+        character.uvMin = glm::vec2((float)pos.x / atlas.width, (float)pos.y / atlas.height);
+        character.uvMax = glm::vec2((float)(pos.x + character.size.x) / atlas.width, (float)(pos.y + character.size.y) / atlas.height);
+        pageFrames[character.page] = frame;
+    }
+    assignIndex(character);
+    cacheDirty = true;
+    return &glyphs.insert(key, character);
+}
+
+void FontsManager::assignIndex(Character &character){
+    character.index = -1;
+    if (character.page < 0)
+        return;
+    if (!freeIndices.empty()) {
+        character.index = freeIndices.back();
+        freeIndices.pop_back();
+    }else{
+        character.index = (int)(metrics.size() / 2);
+        metrics.resize(metrics.size() + 2);
+    }
+    // 以基线起点为原点的左下角偏移和尺寸(基准像素)
+    metrics[character.index * 2] = glm::vec4(character.Bearing.x, character.Bearing.y - character.size.y, character.size.x, character.size.y);
+    metrics[character.index * 2 + 1] = glm::vec4(character.uvMin.x, character.uvMin.y, character.uvMax.x, character.uvMax.y);
+    metricsDirty = true;
+}
+
+void FontsManager::resetMetrics(){
+    metrics.clear();
+    freeIndices.clear();
+    metricsDirty = true;
+}
+
+void FontsManager::preload(const vector<uint32_t> &codepoints, int font, int threads){
+    if (font < 0 || font >= (int)fonts.size())
+        return;
+    // 只光栅化还没有缓存的字形
+    struct Staged{
+        uint32_t codepoint;
+        bool tried;     // 所有线程都没能打开字体时, 码点可能没有被尝试过
+        bool ok;
+        Character character;
+        vector<unsigned char> data;
+    };
+    // 重复的码点只光栅化一次
+    vector<uint32_t> unique(codepoints);
+    sort(unique.begin(), unique.end());
+    unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+    vector<Staged> staged;
+    for (size_t i = 0; i < unique.size(); i++) {
+        uint64_t key = glyphKey(font, pixelSize, unique[i]);
+        if (glyphs.find(key) != NULL || failedGlyphs.find(key) != NULL)
+            continue;
+        staged.push_back(Staged());
+        staged.back().codepoint = unique[i];
+        staged.back().tried = staged.back().ok = false;
+    }
+    if (staged.empty())
+        return;
+
+    threads = min(workerThreadCount(threads), (int)(staged.size() / PRELOAD_MIN_GLYPHS_PER_THREAD) + 1);
+    if (threads <= 1) {
+        if (!openFace(font))
+            return;
+        for (size_t i = 0; i < staged.size(); i++) {
+            staged[i].tried = true;
+            staged[i].ok = rasterize(fonts[font].face, staged[i].codepoint, staged[i].data, staged[i].character);
+        }
+    }else{
+        // FT_Library/FT_Face 不是线程安全的, 每个任务各开一份, 共享只读的字体数据
+        const AssetFile &file = *fonts[font].file;
+        atomic<size_t> next(0);
+        atomic<int> faceErrors(0);
+        WorkerPool::shared().run(threads, [&](int){
+            FT_Library workerLibrary;
+            FT_Face face;
+            // 工作线程不输出, 错误留到调用线程统一报告
+            if (FT_Init_FreeType(&workerLibrary)) {
+                faceErrors++;
+                return;
+            }
+            if (FT_New_Memory_Face(workerLibrary, file.data(), (FT_Long)file.size(), 0, &face) == 0) {
+                // 字形耗时差别很大(尤其是距离场), 按个领取任务
+                for (size_t i = next++; i < staged.size(); i = next++) {
+                    staged[i].tried = true;
+                    staged[i].ok = rasterize(face, staged[i].codepoint, staged[i].data, staged[i].character);
+                }
+                FT_Done_Face(face);
+            }else{
+                faceErrors++;
+            }
+            FT_Done_FreeType(workerLibrary);
+        });
+        if (faceErrors > 0)
+            cout << "ERROR::FREETYPE: " << faceErrors << " preload tasks could not open the font" << endl;
+    }
+
+    // 在当前线程按高度从大到小合并进图集, GL上传留给 commit()
+    vector<size_t> order;
+    for (size_t i = 0; i < staged.size(); i++) {
+        if (staged[i].ok) {
+            order.push_back(i);
             continue;
         }
-        
-        // 生成字体纹理
-        GLuint texture;
-        glGenTextures(1, &texture);
-        
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, face->glyph->bitmap.width, face->glyph->bitmap.rows, 0, GL_RED, GL_UNSIGNED_BYTE, face->glyph->bitmap.buffer);
-        
-        // 设置纹理选项
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        
-        Character character = {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            face->glyph->advance.x
-        };
-        Characters.insert(pair<GLchar, Character>(c, character));
-    }
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+        if (!staged[i].tried)
+            continue;
+        cout << "ERROR::FREETYTPE: Failed to load Glyph " << staged[i].codepoint << endl;
+        failedGlyphs.insert(glyphKey(font, pixelSize, staged[i].codepoint), 1);
+    }
+    sort(order.begin(), order.end(), [&](size_t a, size_t b){ return staged[a].character.size.y > staged[b].character.size.y; });
+    for (size_t i = 0; i < order.size(); i++) {
+        Staged &glyph = staged[order[i]];
+        store(glyphKey(font, pixelSize, glyph.codepoint), glyph.character, glyph.data);
+    }
+}
+
+bool FontsManager::rasterize(FT_Face face, uint32_t codepoint, vector<unsigned char> &data, Character &character) const{
+    int upscale = sdf ? SDF_UPSCALE : 1;
+    FT_Set_Pixel_Sizes(face, 0, pixelSize * upscale);
+    // 加载字体
+    // 可能在工作线程中调用, 不在这里输出错误
+    if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER))
+        return false;
+    FT_Bitmap &bitmap = face->glyph->bitmap;
+    character.Advance = face->glyph->advance.x / upscale;
+    character.uvMin = character.uvMax = glm::vec2(0.0f);
+    if (sdf && bitmap.width > 0 && bitmap.rows > 0) {
+        // 让字形原点对齐到格子边界, bearing 换算回基准像素后仍是整数
+        int left = floorDiv(face->glyph->bitmap_left, upscale);
+        int top = -floorDiv(-face->glyph->bitmap_top, upscale);
+        int originX = face->glyph->bitmap_left - left * upscale;
+        int originY = top * upscale - face->glyph->bitmap_top;
+        buildDistanceField(bitmap.buffer, bitmap.width, bitmap.rows, bitmap.pitch, originX, originY, upscale, sdfSpread,
+                           data, character.size.x, character.size.y);
+        character.Bearing = glm::ivec2(left - sdfSpread, top + sdfSpread);
+    }else{
+        character.size = glm::ivec2(bitmap.width, bitmap.rows);
+        character.Bearing = glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+        data.resize((size_t)bitmap.width * bitmap.rows);
+        for (int row = 0; row < (int)bitmap.rows; row++)
+            memcpy(data.data() + row * bitmap.width, bitmap.buffer + row * bitmap.pitch, bitmap.width);
+    }
+    return true;
+}
+
+int FontsManager::addPage(){
+    pages.push_back(GlyphAtlas());
+    pages.back().create(pageSize, pageSize);
+    pageFrames.push_back(frame);
+    return (int)pages.size() - 1;
+}
+
+int FontsManager::allocate(int w, int h, glm::ivec2 &pos){
+    for (size_t i = 0; i < pages.size(); i++)
+        if (pages[i].pack(w, h, pos))
+            return (int)i;
+    if ((int)pages.size() < maxPages) {
+        int page = addPage();
+        return pages[page].pack(w, h, pos) ? page : -1;
+    }
+
+    // 所有页都满了: 淘汰最久未使用的页. 本帧用到的页上还有待绘制的文字, 不能淘汰
+    int victim = -1;
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (pageFrames[i] == frame)
+            continue;
+        if (victim == -1 || pageFrames[i] < pageFrames[victim])
+            victim = (int)i;
+    }
+    if (victim == -1) {
+        // 一帧的文字就超过了上限, 只能临时多开一页, 之后没有用到时由 beginFrame 收回
+        victim = addPage();
+    }else{
+        forgetPage(victim);
+        pages[victim].create(pageSize, pageSize);
+        pageFrames[victim] = frame;
+    }
+    return pages[victim].pack(w, h, pos) ? victim : -1;
+}
+
+// 删除一页上的所有字形, 之后这一页可以清空重用或释放
+void FontsManager::forgetPage(int page){
+    glyphs.eraseIf([this, page](uint64_t, const Character &character){
+        if (character.page != page)
+            return false;
+        freeIndices.push_back(character.index);
+        return true;
+    });
+    evictions++;
+    cacheDirty = true;
+}
+
+void FontsManager::touchPage(int page){
+    if (page >= 0 && page < (int)pageFrames.size())
+        pageFrames[page] = frame;
+}
+
+void FontsManager::commit(){
+    for (size_t i = 0; i < pages.size(); i++)
+        pages[i].upload();
+    if (!metricsDirty || metrics.empty())
+        return;
+    if (metricsBufferID == 0) {
+        glGenBuffers(1, &metricsBufferID);
+        glGenTextures(1, &metricsTextureID);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, metricsBufferID);
+    glBufferData(GL_TEXTURE_BUFFER, metrics.size() * sizeof(glm::vec4), &metrics[0], GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, metricsTextureID);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, metricsBufferID);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    metricsDirty = false;
+}
+
+void FontsManager::release(){
+    for (size_t i = 0; i < pages.size(); i++)
+        pages[i].release();
+    pages.clear();
+    pageFrames.clear();
+    glyphs.clear();
+    failedGlyphs.clear();
+    resetMetrics();
+    if (metricsBufferID != 0) {
+        glDeleteBuffers(1, &metricsBufferID);
+        glDeleteTextures(1, &metricsTextureID);
+    }
+    metricsBufferID = metricsTextureID = 0;
+    for (size_t i = 0; i < fonts.size(); i++) {
+        if (fonts[i].face != NULL)
+            FT_Done_Face(fonts[i].face);
+        delete fonts[i].file;
+    }
+    cache.close();
+    cacheDirty = true;
+    fonts.clear();
+    if (library != NULL)
+        FT_Done_FreeType(library);
+    library = NULL;
 }
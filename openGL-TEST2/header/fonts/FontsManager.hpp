@@ -10,28 +10,103 @@
 #define FONTSMANAGER_H
 
 #include <iostream>
-#include <map>
+#include <vector>
+#include <stdint.h>
 #include <glm/glm.hpp>
 #include <ft2build.h>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include FT_FREETYPE_H
 
+#include "glyphAtlas.hpp"
+#include "../util/flatHashMap.hpp"
+#include "fontCache.hpp"
+
+class AssetFile;
+
+// 字形缓存: 字形在第一次用到时才光栅化, 排进固定大小的图集页;
+// 页数达到上限后按 LRU 整页淘汰(本帧用到的页不会被淘汰); 一帧的文字超过上限时临时多开的页,
+// 在之后某帧没有用到时由 beginFrame 收回. 光栅化失败的字形也记下来, 不会每帧重试.
+// 图集和字形度量可以存成缓存文件, 命中时直接从 mmap 的文件上传, 完全不需要 FreeType.
 class FontsManager{
 public:
     struct Character{
-        GLuint TextureID;
         glm::ivec2 size;
         glm::ivec2 Bearing;
         long Advance;
+        glm::vec2 uvMin;    // 字形在图集中的纹理坐标(左上)
+        glm::vec2 uvMax;    // 字形在图集中的纹理坐标(右下)
+        int page;           // 所在的图集页
+        int index;          // 在字形度量缓冲中的编号(实例化渲染用), 没有位图时为 -1
     };
-    std::map<char, Character> Characters;
+    // 图集页
+    std::vector<GlyphAtlas> pages;
+    // 字形的基准像素高度, Character 中的尺寸都以它为单位
+    int pixelSize;
+    // 距离场模式: 图集中存的是有向距离场, 任意缩放和描边都用同一份图集(需配合 shader_fonts_sdf.fs)
+    bool sdf;
+    int sdfSpread;      // 距离场的有效范围(像素)
+    int pageSize;       // 图集页的边长
+    int maxPages;       // 图集页数上限
     
     FontsManager();
     
-    void load_fonts(char *font_path);
+    // 加载字体, 返回字体编号(从0开始), 失败返回 -1. FreeType 直到第一次光栅化时才初始化
+    int load_fonts(char *font_path);
+    // 读取缓存文件(在 load_fonts 之后调用), 字体、像素大小等不匹配时返回 false
+    bool loadCache(const char *path);
+    // 有新字形时写出缓存文件
+    bool saveCache(const char *path);
+    // 每帧开始时调用, 用于 LRU 淘汰
+    void beginFrame();
+    // 查找字形, 没有缓存时立即光栅化; 返回的指针在下一次 getGlyph 之前有效
+    const Character *getGlyph(uint32_t codepoint, int font = 0);
+    // 预先光栅化一批字形: 每个工作线程各自持有 FT_Library/FT_Face, 光栅化到各自的暂存位图,
+    // 最后在调用线程合并进图集. threads 为0时使用全部硬件线程. 之后仍需 commit() 上传
+    void preload(const std::vector<uint32_t> &codepoints, int font = 0, int threads = 0);
+    // 把新光栅化的字形上传到图集纹理(需要GL上下文)
+    void commit();
+    // 标记图集页在本帧被使用(直接绘制缓存顶点、不经过 getGlyph 时调用)
+    void touchPage(int page);
+    // 每淘汰一页加1, 缓存了纹理坐标的对象据此判断是否需要重建
+    unsigned int generation() const { return evictions; }
+    // 字形度量的缓冲纹理(GL_RGBA32F, 每个字形两个 texel: 左下角偏移与尺寸, uvMin 与 uvMax), commit() 时更新
+    GLuint metricsTexture() const { return metricsTextureID; }
+    void release();
+
+    size_t glyphCount() const { return glyphs.size(); }
+
 private:
-    
+    struct Font{
+        AssetFile *file;    // 字体数据需要在 face 释放之前一直有效
+        FT_Face face;       // 第一次光栅化时才创建
+        uint64_t hash;      // 字体文件内容的哈希
+    };
+    FT_Library library;
+    std::vector<Font> fonts;
+    // 键: 字体编号(16位) | 像素大小(16位) | 码点(32位)
+    FlatHashMap<Character> glyphs;
+    FlatHashMap<char> failedGlyphs;         // 光栅化失败或放不进图集页的字形, 键同上
+    std::vector<unsigned int> pageFrames;   // 每页最近一次被使用的帧号
+    unsigned int frame;
+    unsigned int evictions;
+    // 字形度量表, 与 Character::index 对应
+    std::vector<glm::vec4> metrics;
+    std::vector<int> freeIndices;
+    bool metricsDirty;
+    GLuint metricsBufferID, metricsTextureID;
+    FontCacheFile cache;    // 缓存文件的映射, 恢复的图集页直接引用其中的像素
+    bool cacheDirty;        // 加载缓存之后是否有新字形或淘汰
+
+    bool openFace(int font);
+    static uint64_t glyphKey(int font, int size, uint32_t codepoint);
+    bool rasterize(FT_Face face, uint32_t codepoint, std::vector<unsigned char> &data, Character &character) const;
+    const Character *store(uint64_t key, Character &character, const std::vector<unsigned char> &data);
+    int allocate(int w, int h, glm::ivec2 &pos);
+    int addPage();
+    void forgetPage(int page);
+    void assignIndex(Character &character);
+    void resetMetrics();
 };
 
 
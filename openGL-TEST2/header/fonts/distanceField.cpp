@@ -0,0 +1,105 @@
+//
+//  distanceField.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/19.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "distanceField.hpp"
+
+#include <math.h>
+
+using namespace std;
+
+// 用一个很大的有限值表示"无穷远", 避免 FLT_MAX 相减得到 NaN
+static const float DISTANCE_INF = 1e20f;
+
+// 一维平方距离变换(Felzenszwalb & Huttenlocher), f 为输入代价, d 为输出
+static void distanceTransform1D(const float *f, int n, float *d, int *v, float *z){
+    int k = 0;
+    v[0] = 0;
+    z[0] = -DISTANCE_INF;
+    z[1] = DISTANCE_INF;
+    for (int q = 1; q < n; q++) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+        while (s <= z[k]) {
+            k--;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = DISTANCE_INF;
+    }
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q)
+            k++;
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+// 二维平方距离变换: grid 中为0的像素是目标, 其余为 DISTANCE_INF
+static void distanceTransform2D(vector<float> &grid, int width, int height){
+    int n = width > height ? width : height;
+    vector<float> f(n), d(n), z(n + 1);
+    vector<int> v(n);
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++)
+            f[y] = grid[(size_t)y * width + x];
+        distanceTransform1D(&f[0], height, &d[0], &v[0], &z[0]);
+        for (int y = 0; y < height; y++)
+            grid[(size_t)y * width + x] = d[y];
+    }
+    for (int y = 0; y < height; y++) {
+        float *row = &grid[(size_t)y * width];
+        for (int x = 0; x < width; x++)
+            f[x] = row[x];
+        distanceTransform1D(&f[0], width, &d[0], &v[0], &z[0]);
+        for (int x = 0; x < width; x++)
+            row[x] = d[x];
+    }
+}
+
+void buildDistanceField(const unsigned char *bitmap, int width, int height, int pitch,
+                        int originX, int originY, int downscale, int spread,
+                        vector<unsigned char> &field, int &fieldWidth, int &fieldHeight){
+    // 高分辨率网格: 四周各留 spread 个输出像素, 并向上取整到格子边界
+    int pad = spread * downscale;
+    fieldWidth = (originX + width + downscale - 1) / downscale + 2 * spread;
+    fieldHeight = (originY + height + downscale - 1) / downscale + 2 * spread;
+    int hiWidth = fieldWidth * downscale, hiHeight = fieldHeight * downscale;
+
+    // inside: 到最近字形像素的平方距离; outside: 到最近背景像素的平方距离
+    vector<float> inside((size_t)hiWidth * hiHeight, DISTANCE_INF);
+    vector<float> outside((size_t)hiWidth * hiHeight, 0.0f);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (bitmap[y * pitch + x] < 128)
+                continue;
+            size_t index = (size_t)(pad + originY + y) * hiWidth + (pad + originX + x);
+            inside[index] = 0.0f;
+            outside[index] = DISTANCE_INF;
+        }
+    }
+    distanceTransform2D(inside, hiWidth, hiHeight);
+    distanceTransform2D(outside, hiWidth, hiHeight);
+
+    // 在每个格子的中心采样, 换算成输出像素后映射到 [0, 1]
+    field.resize((size_t)fieldWidth * fieldHeight);
+    float scale = 1.0f / (2.0f * spread * downscale);
+    for (int y = 0; y < fieldHeight; y++) {
+        for (int x = 0; x < fieldWidth; x++) {
+            size_t index = (size_t)(y * downscale + downscale / 2) * hiWidth + (x * downscale + downscale / 2);
+            // 像素中心到边缘还差半个像素
+            float distance = inside[index] > 0.0f ? sqrtf(inside[index]) - 0.5f : -(sqrtf(outside[index]) - 0.5f);
+            float value = 0.5f - distance * scale;
+            if (value < 0.0f)
+                value = 0.0f;
+            if (value > 1.0f)
+                value = 1.0f;
+            field[(size_t)y * fieldWidth + x] = (unsigned char)(value * 255.0f + 0.5f);
+        }
+    }
+}
@@ -0,0 +1,25 @@
+//
+//  distanceField.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/19.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <vector>
+
+// 有向距离场(SDF)生成.
+// 输入是放大 downscale 倍光栅化的字形位图, 在高分辨率下做精确欧氏距离变换,
+// 再按 downscale x downscale 的格子采样输出. 输出 0.5 为字形边缘, 大于 0.5 在字形内部,
+// 距离 spread(输出像素)处饱和到 0 或 1.
+//
+// originX/originY 是位图左上角在第一个格子内的偏移(0 ~ downscale-1),
+// 用来让字形的原点落在格子边界上, 这样输出的 bearing 可以保持整数.
+void buildDistanceField(const unsigned char *bitmap, int width, int height, int pitch,
+                        int originX, int originY, int downscale, int spread,
+                        std::vector<unsigned char> &field, int &fieldWidth, int &fieldHeight);
+
+#endif /* distanceField_hpp */
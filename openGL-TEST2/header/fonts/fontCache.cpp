@@ -0,0 +1,85 @@
+//
+//  fontCache.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/22.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "fontCache.hpp"
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+FontCacheFile::FontCacheFile() : base(NULL), length(0){
+}
+
+FontCacheFile::~FontCacheFile(){
+    close();
+}
+
+bool FontCacheFile::open(const char *path){
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FontCacheHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void *mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+    base = (const unsigned char *)mapped;
+    length = (size_t)st.st_size;
+
+    const FontCacheHeader &h = header();
+    if (memcmp(h.magic, FONT_CACHE_MAGIC, 4) != 0 || h.version != FONT_CACHE_VERSION) {
+        close();
+        return false;
+    }
+    uint64_t pageBytes = (uint64_t)h.pageSize * h.pageSize;
+    if (h.hashesOffset + (uint64_t)h.fontCount * sizeof(uint64_t) > length ||
+        h.glyphsOffset + (uint64_t)h.glyphCount * sizeof(FontCacheGlyph) > length ||
+        h.pagesOffset + (uint64_t)h.pageCount * sizeof(FontCachePage) > length ||
+        h.shelvesOffset + (uint64_t)h.shelfCount * sizeof(FontCacheShelf) > length ||
+        h.pixelsOffset + (uint64_t)h.pageCount * pageBytes > length) {
+        cout << "ERROR::FONT_CACHE: Corrupted font cache " << path << endl;
+        close();
+        return false;
+    }
+    for (uint32_t i = 0; i < h.pageCount; i++) {
+        if ((uint64_t)pages()[i].firstShelf + pages()[i].shelfCount > h.shelfCount) {
+            cout << "ERROR::FONT_CACHE: Corrupted font cache " << path << endl;
+            close();
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h.glyphCount; i++) {
+        if (glyphs()[i].page >= (int32_t)h.pageCount) {
+            cout << "ERROR::FONT_CACHE: Corrupted font cache " << path << endl;
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void FontCacheFile::close(){
+    if (base != NULL)
+        munmap((void *)base, length);
+    base = NULL;
+    length = 0;
+}
+
+const unsigned char *FontCacheFile::pagePixels(uint32_t page) const{
+    return base + header().pixelsOffset + (uint64_t)page * header().pageSize * header().pageSize;
+}
+
@@ -0,0 +1,92 @@
+//
+//  fontCache.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/22.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef FONT_CACHE_H
+#define FONT_CACHE_H
+
+#include <iostream>
+#include <stdint.h>
+
+// 字形缓存文件格式(FontsManager::saveCache 写出, loadCache 时 mmap):
+// [FontCacheHeader][字体哈希 x fontCount][FontCacheGlyph x glyphCount][FontCachePage x pageCount]
+// [FontCacheShelf x shelfCount][按 alignment 对齐, 每页 pageSize*pageSize 字节的图集像素...]
+// 字体文件内容、像素大小、距离场参数任何一项不同都视为未命中.
+#define FONT_CACHE_MAGIC "FNTC"
+#define FONT_CACHE_VERSION 1
+#define FONT_CACHE_ALIGNMENT 64
+
+struct FontCacheHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t pixelSize;
+    uint32_t sdf;
+    uint32_t sdfSpread;
+    uint32_t pageSize;
+    uint32_t fontCount;
+    uint32_t glyphCount;
+    uint32_t pageCount;
+    uint32_t shelfCount;
+    uint64_t hashesOffset;
+    uint64_t glyphsOffset;
+    uint64_t pagesOffset;
+    uint64_t shelvesOffset;
+    uint64_t pixelsOffset;
+};
+
+struct FontCacheGlyph{
+    uint64_t key;           // 与 FontsManager 的字形键相同
+    int32_t size[2];
+    int32_t bearing[2];
+    int64_t advance;
+    float uvMin[2];
+    float uvMax[2];
+    int32_t page;
+    int32_t reserved;
+};
+
+struct FontCachePage{
+    uint32_t firstShelf;
+    uint32_t shelfCount;
+    int32_t nextY;
+    int32_t reserved;
+};
+
+struct FontCacheShelf{
+    int32_t y;
+    int32_t height;
+    int32_t x;
+};
+
+// 只读映射的缓存文件
+class FontCacheFile{
+public:
+    FontCacheFile();
+    ~FontCacheFile();
+
+    // 映射并校验文件结构, 失败时返回 false
+    bool open(const char *path);
+    void close();
+    bool isOpen() const { return base != NULL; }
+
+    const FontCacheHeader &header() const { return *(const FontCacheHeader *)base; }
+    const uint64_t *fontHashes() const { return (const uint64_t *)(base + header().hashesOffset); }
+    const FontCacheGlyph *glyphs() const { return (const FontCacheGlyph *)(base + header().glyphsOffset); }
+    const FontCachePage *pages() const { return (const FontCachePage *)(base + header().pagesOffset); }
+    const FontCacheShelf *shelves() const { return (const FontCacheShelf *)(base + header().shelvesOffset); }
+    const unsigned char *pagePixels(uint32_t page) const;
+
+private:
+    const unsigned char *base;
+    size_t length;
+
+    FontCacheFile(const FontCacheFile &);
+    FontCacheFile &operator=(const FontCacheFile &);
+};
+
+
+#endif /* fontCache_hpp */
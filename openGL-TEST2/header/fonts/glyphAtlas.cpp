@@ -0,0 +1,121 @@
+//
+//  glyphAtlas.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/17.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "glyphAtlas.hpp"
+
+#include <string.h>
+#include <algorithm>
+
+using namespace std;
+
+// 字形之间留1像素空隙, 防止线性过滤时采样到相邻字形
+static const int GLYPH_PADDING = 1;
+
+GlyphAtlas::GlyphAtlas() : TextureID(0), width(0), height(0), source(NULL), nextY(0), dirtyMinY(0), dirtyMaxY(0), textureWidth(0), textureHeight(0){
+}
+
+void GlyphAtlas::create(int width, int height){
+    this->width = width;
+    this->height = height;
+    pixels.assign((size_t)width * height, 0);
+    source = NULL;
+    shelves.clear();
+    nextY = 0;
+    dirtyMinY = 0;
+    dirtyMaxY = height;
+}
+
+void GlyphAtlas::restore(int width, int height, const unsigned char *source, const vector<Shelf> &shelves, int nextY){
+    this->width = width;
+    this->height = height;
+    this->source = source;
+    this->shelves = shelves;
+    this->nextY = nextY;
+    pixels.clear();
+    dirtyMinY = 0;
+    dirtyMaxY = height;
+}
+
+bool GlyphAtlas::pack(int w, int h, glm::ivec2 &pos){
+    int pw = w + GLYPH_PADDING, ph = h + GLYPH_PADDING;
+    // 选择能放下且高度浪费最少的行
+    int best = -1;
+    for (size_t i = 0; i < shelves.size(); i++) {
+        const Shelf &shelf = shelves[i];
+        if (shelf.height < ph || shelf.x + pw > width)
+            continue;
+        if (best == -1 || shelf.height < shelves[best].height)
+            best = (int)i;
+    }
+    if (best == -1) {
+        // 新开一行
+        if (nextY + ph > height || pw > width)
+            return false;
+        Shelf shelf = {nextY, ph, 0};
+        shelves.push_back(shelf);
+        nextY += ph;
+        best = (int)shelves.size() - 1;
+    }
+    Shelf &shelf = shelves[best];
+    pos = glm::ivec2(shelf.x, shelf.y);
+    shelf.x += pw;
+    return true;
+}
+
+void GlyphAtlas::blit(const unsigned char *bitmap, int w, int h, int pitch, const glm::ivec2 &pos){
+    if (pixels.empty() && source != NULL)
+        pixels.assign(source, source + (size_t)width * height);
+    for (int row = 0; row < h; row++)
+        memcpy(&pixels[(size_t)(pos.y + row) * width + pos.x], bitmap + row * pitch, w);
+    if (h <= 0)
+        return;
+    if (!dirty()) {
+        dirtyMinY = pos.y;
+        dirtyMaxY = pos.y + h;
+    }else{
+        dirtyMinY = min(dirtyMinY, pos.y);
+        dirtyMaxY = max(dirtyMaxY, pos.y + h);
+    }
+}
+
+void GlyphAtlas::upload(){
+    if (TextureID != 0 && !dirty())
+        return;
+    bool allocate = TextureID == 0 || textureWidth != width || textureHeight != height;
+    if (TextureID == 0)
+        glGenTextures(1, &TextureID);
+    glBindTexture(GL_TEXTURE_2D, TextureID);
+    GLint alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (allocate) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, data());
+        textureWidth = width;
+        textureHeight = height;
+
+        // 设置纹理选项
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }else{
+        // 只上传脏行(整行宽度, 行与行连续)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirtyMinY, width, dirtyMaxY - dirtyMinY, GL_RED, GL_UNSIGNED_BYTE, data() + (size_t)dirtyMinY * width);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    dirtyMinY = dirtyMaxY = 0;
+}
+
+void GlyphAtlas::release(){
+    if (TextureID != 0)
+        glDeleteTextures(1, &TextureID);
+    TextureID = 0;
+    source = NULL;
+    textureWidth = textureHeight = 0;
+}
@@ -0,0 +1,62 @@
+//
+//  glyphAtlas.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/17.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <iostream>
+#include <vector>
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+// 字形图集(一页): 字形光栅化后用 shelf 算法排进同一张单通道纹理,
+// 渲染文字时每页只需绑定一次纹理. 新写入的区域记为脏行, upload 时只上传这些行.
+class GlyphAtlas{
+public:
+    GLuint TextureID;
+    int width;
+    int height;
+    std::vector<unsigned char> pixels;   // CPU 端的图集数据(GL_RED)
+
+    struct Shelf{
+        int y;
+        int height;
+        int x;      // 当前行已使用的宽度
+    };
+
+    GlyphAtlas();
+
+    // 清空并分配 width x height 的图集(已有的GL纹理保留, 下次 upload 时整体重传)
+    void create(int width, int height);
+    // 从外部内存(如 mmap 的缓存文件)恢复图集; source 在 release 之前必须一直有效,
+    // 第一次 blit 时才拷贝到 pixels
+    void restore(int width, int height, const unsigned char *source, const std::vector<Shelf> &shelves, int nextY);
+    // 为 w x h 的字形找一块空间, 放不下时返回 false
+    bool pack(int w, int h, glm::ivec2 &pos);
+    // 把字形位图拷贝到图集的 pos 处
+    void blit(const unsigned char *bitmap, int w, int h, int pitch, const glm::ivec2 &pos);
+    // 把脏区域上传到GL纹理, 首次调用时创建纹理(需要GL上下文)
+    void upload();
+    bool dirty() const { return dirtyMinY < dirtyMaxY; }
+    void release();
+
+    // 图集像素(pixels 或恢复时的外部内存)
+    const unsigned char *data() const { return pixels.empty() ? source : &pixels[0]; }
+    const std::vector<Shelf> &getShelves() const { return shelves; }
+    int usedHeight() const { return nextY; }
+
+private:
+    const unsigned char *source;
+    std::vector<Shelf> shelves;
+    int nextY;
+    int dirtyMinY, dirtyMaxY;   // 待上传的行范围 [min, max)
+    int textureWidth, textureHeight;
+};
+
+#endif /* glyphAtlas_hpp */
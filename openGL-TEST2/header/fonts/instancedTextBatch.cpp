@@ -0,0 +1,176 @@
+//
+//  instancedTextBatch.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/24.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "instancedTextBatch.hpp"
+#include "utf8.hpp"
+
+#include <stddef.h>
+#include <string.h>
+
+using namespace std;
+
+// 缩放的定点精度
+static const float SCALE_FIXED_ONE = 1024.0f;
+
+InstancedTextBatch::InstancedTextBatch() : VAO(0), VBO(0), instanceCapacity(0), lastUploadBytes(0), lastDrawCalls(0){
+}
+
+void InstancedTextBatch::create(){
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    // 三个属性都是每实例前进一次, 顶点本身没有属性(四边形的角由 gl_VertexID 得到)
+    glVertexAttribDivisor(0, 1);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribDivisor(2, 1);
+    setInstanceOffset(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instanceCapacity = 0;
+}
+
+void InstancedTextBatch::setInstanceOffset(size_t firstInstance){
+    // GL 3.3 没有 baseInstance, 每个图集页绘制前把属性指针移到该页的第一个实例
+    size_t base = firstInstance * sizeof(GlyphInstance);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (void*)(base + offsetof(GlyphInstance, x)));
+    glVertexAttribIPointer(1, 2, GL_UNSIGNED_INT, sizeof(GlyphInstance), (void*)(base + offsetof(GlyphInstance, glyph)));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphInstance), (void*)(base + offsetof(GlyphInstance, color)));
+}
+
+void InstancedTextBatch::begin(){
+    for (size_t i = 0; i < pages.size(); i++)
+        pages[i].instances.clear();
+}
+
+InstancedTextBatch::Page &InstancedTextBatch::pageFor(FontsManager *fonts, int atlasPage){
+    for (size_t i = 0; i < pages.size(); i++)
+        if (pages[i].fonts == fonts && pages[i].atlasPage == atlasPage)
+            return pages[i];
+    pages.push_back(Page());
+    pages.back().fonts = fonts;
+    pages.back().atlasPage = atlasPage;
+    return pages.back();
+}
+
+void InstancedTextBatch::addText(FontsManager &fonts, const string &text, float x, float y, float scale, const glm::vec3 &color){
+    addText(fonts, text.data(), text.size(), x, y, scale, color);
+}
+
+void InstancedTextBatch::addText(FontsManager &fonts, const char *text, float x, float y, float scale, const glm::vec3 &color){
+    addText(fonts, text, strlen(text), x, y, scale, color);
+}
+
+void InstancedTextBatch::addText(FontsManager &fonts, const char *text, size_t length, float x, float y, float scale, const glm::vec3 &color){
+    GlyphInstance instance;
+    instance.y = y;
+    instance.scale = (uint32_t)glm::clamp(scale * SCALE_FIXED_ONE + 0.5f, 0.0f, 65535.0f);
+    instance.color[0] = (GLubyte)(glm::clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+    instance.color[1] = (GLubyte)(glm::clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+    instance.color[2] = (GLubyte)(glm::clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+    instance.color[3] = 255;
+
+    const char *c = text, *end = text + length;
+    while (c < end) {
+        const FontsManager::Character *glyph = fonts.getGlyph(utf8Next(c, end));
+        if (glyph == NULL)
+            continue;
+        if (glyph->index >= 0) {
+            instance.x = x;
+            instance.glyph = (uint32_t)glyph->index;
+            pageFor(&fonts, glyph->page).instances.push_back(instance);
+        }
+        x += (glyph->Advance >> 6) * scale;
+    }
+}
+
+size_t InstancedTextBatch::glyphCount() const{
+    size_t count = 0;
+    for (size_t i = 0; i < pages.size(); i++)
+        count += pages[i].instances.size();
+    return count;
+}
+
+void InstancedTextBatch::flush(Shader &shader, const glm::mat4 &projection){
+    lastUploadBytes = 0;
+    lastDrawCalls = 0;
+    size_t count = glyphCount();
+    if (count == 0)
+        return;
+
+    // 1. 孤立旧缓冲后一次映射写入所有实例
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    if (count > instanceCapacity) {
+        if (instanceCapacity == 0)
+            instanceCapacity = 1024;
+        while (instanceCapacity < count)
+            instanceCapacity *= 2;
+    }
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(GlyphInstance), NULL, GL_STREAM_DRAW);
+    GlyphInstance *dst = (GlyphInstance *)glMapBufferRange(GL_ARRAY_BUFFER, 0, count * sizeof(GlyphInstance), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (dst == NULL) {
+        cout << "ERROR::TEXT_BATCH: Failed to map instance buffer" << endl;
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (pages[i].instances.empty())
+            continue;
+        memcpy(dst, &pages[i].instances[0], pages[i].instances.size() * sizeof(GlyphInstance));
+        dst += pages[i].instances.size();
+    }
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    lastUploadBytes = count * sizeof(GlyphInstance);
+    // 新字形的图集和度量
+    for (size_t i = 0; i < pages.size(); i++)
+        if (!pages[i].instances.empty())
+            pages[i].fonts->commit();
+
+    // 2. 每个图集页一次实例化绘制
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setInt1("text", 0);
+    shader.setInt1("glyphMetrics", 1);
+    glBindVertexArray(VAO);
+    size_t firstInstance = 0;
+    for (size_t i = 0; i < pages.size(); i++) {
+        size_t instances = pages[i].instances.size();
+        if (instances == 0)
+            continue;
+        FontsManager *fonts = pages[i].fonts;
+        fonts->touchPage(pages[i].atlasPage);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, fonts->metricsTexture());
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, fonts->pages[pages[i].atlasPage].TextureID);
+        setInstanceOffset(firstInstance);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)instances);
+        firstInstance += instances;
+        lastDrawCalls++;
+    }
+    setInstanceOffset(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void InstancedTextBatch::release(){
+    if (VAO != 0)
+        glDeleteVertexArrays(1, &VAO);
+    if (VBO != 0)
+        glDeleteBuffers(1, &VBO);
+    VAO = VBO = 0;
+    instanceCapacity = 0;
+    pages.clear();
+}
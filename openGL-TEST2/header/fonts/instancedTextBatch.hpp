@@ -0,0 +1,69 @@
+//
+//  instancedTextBatch.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/24.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef INSTANCED_TEXT_BATCH_H
+#define INSTANCED_TEXT_BATCH_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "FontsManager.hpp"
+#include "../shader/shader.hpp"
+
+// 实例化文字批处理: 每个字形是一个实例, 只上传(基线位置, 字形编号, 缩放, 颜色)共20字节,
+// 四边形由顶点着色器(shader_fonts_instanced.vs)从字形度量缓冲纹理中展开.
+// 相比每字符6个顶点 x 4个float(96字节), 上传量约为 1/5, CPU 也不再计算四边形.
+// 字形编号为 32 位, 图集中的字形数没有 65536 的限制.
+class InstancedTextBatch{
+public:
+    InstancedTextBatch();
+
+    // 创建VAO/VBO(需要GL上下文)
+    void create();
+    void begin();
+    void addText(FontsManager &fonts, const std::string &text, float x, float y, float scale, const glm::vec3 &color);
+    void addText(FontsManager &fonts, const char *text, float x, float y, float scale, const glm::vec3 &color);
+    void addText(FontsManager &fonts, const char *text, size_t length, float x, float y, float scale, const glm::vec3 &color);
+    // 上传实例并按图集页绘制
+    void flush(Shader &shader, const glm::mat4 &projection);
+    void release();
+
+    size_t glyphCount() const;
+    // 最近一次 flush 的统计
+    size_t uploadedBytes() const { return lastUploadBytes; }
+    int drawCalls() const { return lastDrawCalls; }
+
+private:
+    struct GlyphInstance{
+        float x, y;         // 基线起点
+        uint32_t glyph;     // Character::index
+        uint32_t scale;     // 缩放, 1/1024 定点数
+        GLubyte color[4];
+    };
+    struct Page{
+        FontsManager *fonts;
+        int atlasPage;
+        std::vector<GlyphInstance> instances;
+    };
+    std::vector<Page> pages;
+
+    GLuint VAO, VBO;
+    size_t instanceCapacity;
+    size_t lastUploadBytes;
+    int lastDrawCalls;
+
+    Page &pageFor(FontsManager *fonts, int atlasPage);
+    void setInstanceOffset(size_t firstInstance);
+};
+
+#endif /* instancedTextBatch_hpp */
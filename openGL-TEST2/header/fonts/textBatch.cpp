@@ -0,0 +1,210 @@
+//
+//  textBatch.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/18.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "textBatch.hpp"
+#include "utf8.hpp"
+
+#include <string.h>
+
+using namespace std;
+
+TextBatch::TextBatch() : VAO(0), VBO(0), EBO(0), vertexCapacity(0), indexQuads(0), lastUploadBytes(0), lastDrawCalls(0){
+}
+
+void TextBatch::create(){
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(TextVertex), (void*)(4 * sizeof(float)));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // HUD 的初始容量: 1024 个字符
+    vertexCapacity = 0;
+    indexQuads = 0;
+    reserveIndices(1024);
+}
+
+void TextBatch::begin(){
+    for (size_t i = 0; i < pages.size(); i++)
+        pages[i].vertices.clear();
+}
+
+TextBatch::Page &TextBatch::pageFor(FontsManager *fonts, int atlasPage){
+    // 图集页数很少, 线性查找即可
+    for (size_t i = 0; i < pages.size(); i++)
+        if (pages[i].fonts == fonts && pages[i].atlasPage == atlasPage)
+            return pages[i];
+    pages.push_back(Page());
+    pages.back().fonts = fonts;
+    pages.back().atlasPage = atlasPage;
+    return pages.back();
+}
+
+void TextBatch::addText(FontsManager &fonts, const string &text, float x, float y, float scale, const glm::vec3 &color){
+    addText(fonts, text.data(), text.size(), x, y, scale, color);
+}
+
+void TextBatch::addText(FontsManager &fonts, const char *text, float x, float y, float scale, const glm::vec3 &color){
+    addText(fonts, text, strlen(text), x, y, scale, color);
+}
+
+void TextBatch::addText(FontsManager &fonts, const char *text, size_t length, float x, float y, float scale, const glm::vec3 &color){
+    GLubyte rgba[4] = {
+        (GLubyte)(glm::clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f),
+        (GLubyte)(glm::clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f),
+        (GLubyte)(glm::clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f),
+        255
+    };
+
+    const char *c = text, *end = text + length;
+    while (c < end) {
+        const FontsManager::Character *glyph = fonts.getGlyph(utf8Next(c, end));
+        if (glyph == NULL)
+            continue;
+        const FontsManager::Character &ch = *glyph;
+        float xPos = x + ch.Bearing.x * scale;
+        float yPos = y - (ch.size.y - ch.Bearing.y) * scale;
+        float w = ch.size.x * scale;
+        float h = ch.size.y * scale;
+        x += (ch.Advance >> 6) * scale;
+        // 空格等没有位图的字符只前进不出四边形
+        if (ch.page < 0)
+            continue;
+
+        // 左上、左下、右下、右上
+        TextVertex quad[4] = {
+            { xPos,     yPos + h,   ch.uvMin.x, ch.uvMin.y, {0, 0, 0, 0} },
+            { xPos,     yPos,       ch.uvMin.x, ch.uvMax.y, {0, 0, 0, 0} },
+            { xPos + w, yPos,       ch.uvMax.x, ch.uvMax.y, {0, 0, 0, 0} },
+            { xPos + w, yPos + h,   ch.uvMax.x, ch.uvMin.y, {0, 0, 0, 0} }
+        };
+        vector<TextVertex> &vertices = pageFor(&fonts, ch.page).vertices;
+        for (int i = 0; i < 4; i++) {
+            memcpy(quad[i].color, rgba, sizeof(rgba));
+            vertices.push_back(quad[i]);
+        }
+    }
+}
+
+size_t TextBatch::quadCount() const{
+    size_t vertices = 0;
+    for (size_t i = 0; i < pages.size(); i++)
+        vertices += pages[i].vertices.size();
+    return vertices / 4;
+}
+
+void TextBatch::reserveIndices(size_t quads){
+    if (quads <= indexQuads)
+        return;
+    size_t capacity = indexQuads > 0 ? indexQuads : 1;
+    while (capacity < quads)
+        capacity *= 2;
+    // 索引只和四边形序号有关, 生成一次后每帧复用
+    vector<GLuint> indices(capacity * 6);
+    for (size_t q = 0; q < capacity; q++) {
+        GLuint base = (GLuint)(q * 4);
+        GLuint *index = &indices[q * 6];
+        index[0] = base;     index[1] = base + 1; index[2] = base + 2;
+        index[3] = base;     index[4] = base + 2; index[5] = base + 3;
+    }
+    glBindVertexArray(VAO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    indexQuads = capacity;
+}
+
+void TextBatch::flush(Shader &shader, const glm::mat4 &projection){
+    upload();
+    draw(shader, projection);
+}
+
+void TextBatch::upload(){
+    lastUploadBytes = 0;
+    size_t quads = quadCount();
+    if (quads == 0)
+        return;
+    size_t vertices = quads * 4;
+
+    // 一次性上传所有页的顶点; 容量不够时按2倍扩容, 否则孤立旧缓冲避免等待上一帧的绘制
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    if (vertices > vertexCapacity) {
+        if (vertexCapacity == 0)
+            vertexCapacity = 4096;
+        while (vertexCapacity < vertices)
+            vertexCapacity *= 2;
+    }
+    glBufferData(GL_ARRAY_BUFFER, vertexCapacity * sizeof(TextVertex), NULL, GL_STREAM_DRAW);
+    TextVertex *dst = (TextVertex *)glMapBufferRange(GL_ARRAY_BUFFER, 0, vertices * sizeof(TextVertex), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (dst == NULL) {
+        cout << "ERROR::TEXT_BATCH: Failed to map vertex buffer" << endl;
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (pages[i].vertices.empty())
+            continue;
+        memcpy(dst, &pages[i].vertices[0], pages[i].vertices.size() * sizeof(TextVertex));
+        dst += pages[i].vertices.size();
+    }
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    lastUploadBytes = vertices * sizeof(TextVertex);
+    reserveIndices(quads);
+    // 新光栅化的字形先上传到图集
+    for (size_t i = 0; i < pages.size(); i++)
+        if (!pages[i].vertices.empty())
+            pages[i].fonts->commit();
+}
+
+void TextBatch::draw(Shader &shader, const glm::mat4 &projection){
+    lastDrawCalls = 0;
+    if (quadCount() == 0)
+        return;
+
+    // 每个图集页一次绘制
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setInt1("text", 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(VAO);
+    size_t firstQuad = 0;
+    for (size_t i = 0; i < pages.size(); i++) {
+        size_t pageQuads = pages[i].vertices.size() / 4;
+        if (pageQuads == 0)
+            continue;
+        // 标记图集页在本帧被使用, 防止被 LRU 淘汰
+        pages[i].fonts->touchPage(pages[i].atlasPage);
+        glBindTexture(GL_TEXTURE_2D, pages[i].fonts->pages[pages[i].atlasPage].TextureID);
+        glDrawElements(GL_TRIANGLES, (GLsizei)(pageQuads * 6), GL_UNSIGNED_INT, (void*)(firstQuad * 6 * sizeof(GLuint)));
+        firstQuad += pageQuads;
+        lastDrawCalls++;
+    }
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TextBatch::release(){
+    if (VAO != 0)
+        glDeleteVertexArrays(1, &VAO);
+    if (VBO != 0)
+        glDeleteBuffers(1, &VBO);
+    if (EBO != 0)
+        glDeleteBuffers(1, &EBO);
+    VAO = VBO = EBO = 0;
+    vertexCapacity = 0;
+    indexQuads = 0;
+    pages.clear();
+}
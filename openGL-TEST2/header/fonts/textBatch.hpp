@@ -0,0 +1,74 @@
+//
+//  textBatch.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/18.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef TEXT_BATCH_H
+#define TEXT_BATCH_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "FontsManager.hpp"
+#include "../shader/shader.hpp"
+
+// 文字批处理: 一帧内所有字符串的四边形先收集到CPU缓冲,
+// flush 时整体上传一次(孤立旧缓冲后映射写入), 每个图集页只绘制一次.
+class TextBatch{
+public:
+    TextBatch();
+
+    // 创建VAO/VBO/EBO(需要GL上下文)
+    void create();
+    // 开始新的一帧, 清空上一帧的四边形(保留容量)
+    void begin();
+    // 追加一行 UTF-8 文字, (x, y) 为基线起点; 缺少的字形在这里按需光栅化
+    void addText(FontsManager &fonts, const std::string &text, float x, float y, float scale, const glm::vec3 &color);
+    // 不构造 std::string 的版本(配合字符串常量和 TextBuffer 使用)
+    void addText(FontsManager &fonts, const char *text, float x, float y, float scale, const glm::vec3 &color);
+    void addText(FontsManager &fonts, const char *text, size_t length, float x, float y, float scale, const glm::vec3 &color);
+    // 上传并绘制所有四边形, 等价于 upload() + draw()
+    void flush(Shader &shader, const glm::mat4 &projection);
+    // 只上传顶点(以及新光栅化的字形)
+    void upload();
+    // 只绘制上一次上传的顶点, 可以每帧重复调用
+    void draw(Shader &shader, const glm::mat4 &projection);
+    void release();
+
+    size_t quadCount() const;
+    // 最近一次 flush 的统计
+    size_t uploadedBytes() const { return lastUploadBytes; }
+    int drawCalls() const { return lastDrawCalls; }
+
+private:
+    struct TextVertex{
+        float x, y;
+        float u, v;
+        GLubyte color[4];
+    };
+    // 同一个图集页上的四边形(纹理在 flush 时才确定, 新建的页这时才有纹理)
+    struct Page{
+        FontsManager *fonts;
+        int atlasPage;
+        std::vector<TextVertex> vertices;
+    };
+    std::vector<Page> pages;
+
+    GLuint VAO, VBO, EBO;
+    size_t vertexCapacity;  // VBO 能容纳的顶点数
+    size_t indexQuads;      // EBO 中已生成索引的四边形数
+    size_t lastUploadBytes;
+    int lastDrawCalls;
+
+    Page &pageFor(FontsManager *fonts, int atlasPage);
+    void reserveIndices(size_t quads);
+};
+
+#endif /* textBatch_hpp */
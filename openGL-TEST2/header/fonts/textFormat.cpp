@@ -0,0 +1,84 @@
+//
+//  textFormat.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/23.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "textFormat.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+TextBuffer::TextBuffer() : length(0){
+    buffer[0] = '\0';
+}
+
+void TextBuffer::clear(){
+    length = 0;
+    buffer[0] = '\0';
+}
+
+TextBuffer &TextBuffer::append(const char *text){
+    return append(text, strlen(text));
+}
+
+TextBuffer &TextBuffer::append(const char *text, size_t count){
+    size_t room = CAPACITY - 1 - length;
+    if (count > room)
+        count = room;
+    memcpy(buffer + length, text, count);
+    length += count;
+    buffer[length] = '\0';
+    return *this;
+}
+
+TextBuffer &TextBuffer::appendInt(long value){
+    // 直接写进剩余空间, snprintf 只用调用者的栈和这块数组
+    int written = snprintf(buffer + length, CAPACITY - length, "%ld", value);
+    if (written > 0)
+        length = length + written < CAPACITY ? length + written : CAPACITY - 1;
+    return *this;
+}
+
+TextBuffer &TextBuffer::appendFixed(double value, int precision){
+    int written = snprintf(buffer + length, CAPACITY - length, "%.*f", precision, value);
+    if (written > 0)
+        length = length + written < CAPACITY ? length + written : CAPACITY - 1;
+    return *this;
+}
+
+TextBuffer &TextBuffer::appendScaled(long long scaled, int precision){
+    unsigned long long divisor = 1;
+    for (int i = 0; i < precision; i++)
+        divisor *= 10;
+    // 取绝对值时避免 LLONG_MIN 溢出
+    unsigned long long magnitude = scaled < 0 ? 0ULL - (unsigned long long)scaled : (unsigned long long)scaled;
+    int written;
+    if (precision > 0)
+        written = snprintf(buffer + length, CAPACITY - length, "%s%llu.%0*llu", scaled < 0 ? "-" : "", magnitude / divisor, precision, magnitude % divisor);
+    else
+        written = snprintf(buffer + length, CAPACITY - length, "%lld", scaled);
+    if (written > 0)
+        length = length + written < CAPACITY ? length + written : CAPACITY - 1;
+    return *this;
+}
+
+NumberField::NumberField(int precision) : precision(precision), shown(0), valid(false){
+    scale = pow(10.0, precision);
+}
+
+bool NumberField::update(double value){
+    long long quantized = llround(value * scale);
+    if (valid && quantized == shown)
+        return false;
+    shown = quantized;
+    valid = true;
+    return true;
+}
+
+void NumberField::appendTo(TextBuffer &text) const{
+    text.appendScaled(shown, precision);
+}
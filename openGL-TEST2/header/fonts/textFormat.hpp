@@ -0,0 +1,58 @@
+//
+//  textFormat.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/23.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef TEXT_FORMAT_H
+#define TEXT_FORMAT_H
+
+#include <stddef.h>
+
+// 固定容量的文字缓冲: 内容放在对象自身的数组里, 拼接和数字格式化都不分配堆内存.
+// 超出容量的部分直接截断.
+class TextBuffer{
+public:
+    enum { CAPACITY = 128 };
+
+    TextBuffer();
+
+    void clear();
+    TextBuffer &append(const char *text);
+    TextBuffer &append(const char *text, size_t length);
+    TextBuffer &appendInt(long value);
+    // 保留 precision 位小数(四舍五入)
+    TextBuffer &appendFixed(double value, int precision);
+    // 显示 scaled / 10^precision, 例如 (-5, 2) 为 "-0.05"; 只做整数运算, 不会再取整一次
+    TextBuffer &appendScaled(long long scaled, int precision);
+
+    const char *c_str() const { return buffer; }
+    size_t size() const { return length; }
+
+private:
+    char buffer[CAPACITY];
+    size_t length;
+};
+
+// 数值字段: 记录上一次显示的值(按显示精度四舍五入成整数), 用来判断是否需要重新格式化.
+// 文字用 appendTo 从同一个整数格式化, 判断和显示不会因为取整方式不同而不一致
+class NumberField{
+public:
+    explicit NumberField(int precision = 0);
+
+    // 按显示精度比较, 显示的文字会变化时返回 true
+    bool update(double value);
+    // 追加上一次 update 的值
+    void appendTo(TextBuffer &text) const;
+    int getPrecision() const { return precision; }
+
+private:
+    int precision;
+    double scale;
+    long long shown;
+    bool valid;
+};
+
+#endif /* textFormat_hpp */
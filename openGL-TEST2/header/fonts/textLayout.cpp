@@ -0,0 +1,89 @@
+//
+//  textLayout.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/21.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "textLayout.hpp"
+
+#include <string.h>
+
+using namespace std;
+
+TextLayout::TextLayout() : runCount(0), dirty(true), rebuildCount(0), lastUploadBytes(0){
+}
+
+void TextLayout::create(){
+    batch.create();
+    dirty = true;
+}
+
+void TextLayout::begin(){
+    runCount = 0;
+}
+
+void TextLayout::addText(FontsManager &fonts, const string &text, float x, float y, float scale, const glm::vec3 &color){
+    addText(fonts, text.data(), text.size(), x, y, scale, color);
+}
+
+void TextLayout::addText(FontsManager &fonts, const char *text, float x, float y, float scale, const glm::vec3 &color){
+    addText(fonts, text, strlen(text), x, y, scale, color);
+}
+
+void TextLayout::addText(FontsManager &fonts, const char *text, size_t length, float x, float y, float scale, const glm::vec3 &color){
+    // 与上一帧同一位置的行逐项比较, 完全相同就沿用缓存
+    if (runCount < runs.size()) {
+        Run &run = runs[runCount];
+        if (run.fonts == &fonts && run.x == x && run.y == y && run.scale == scale && run.color == color && run.text.compare(0, string::npos, text, length) == 0) {
+            runCount++;
+            return;
+        }
+    }else{
+        runs.push_back(Run());
+    }
+    Run &run = runs[runCount++];
+    run.fonts = &fonts;
+    run.text.assign(text, length);
+    run.x = x;
+    run.y = y;
+    run.scale = scale;
+    run.color = color;
+    dirty = true;
+}
+
+void TextLayout::draw(Shader &shader, const glm::mat4 &projection){
+    if (runCount != runs.size()) {
+        runs.resize(runCount);
+        dirty = true;
+    }
+    // 字形所在的页被淘汰后, 缓存的纹理坐标已经失效
+    for (size_t i = 0; i < runs.size() && !dirty; i++)
+        if (runs[i].fonts->generation() != runs[i].generation)
+            dirty = true;
+
+    lastUploadBytes = 0;
+    if (dirty) {
+        batch.begin();
+        for (size_t i = 0; i < runs.size(); i++) {
+            Run &run = runs[i];
+            batch.addText(*run.fonts, run.text, run.x, run.y, run.scale, run.color);
+        }
+        // 排版过程中也可能发生淘汰, 所以在全部排完之后再记录
+        for (size_t i = 0; i < runs.size(); i++)
+            runs[i].generation = runs[i].fonts->generation();
+        batch.upload();
+        lastUploadBytes = batch.uploadedBytes();
+        dirty = false;
+        rebuildCount++;
+    }
+    batch.draw(shader, projection);
+}
+
+void TextLayout::release(){
+    batch.release();
+    runs.clear();
+    runCount = 0;
+    dirty = true;
+}
@@ -0,0 +1,60 @@
+//
+//  textLayout.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/21.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "textBatch.hpp"
+
+// 保留模式的文字排版: 排好的四边形常驻在自己的顶点缓冲里,
+// 只有文字、位置、缩放、颜色或字体变化(或字形所在的图集页被淘汰)时才重新排版上传,
+// 其余帧只剩每个图集页一次绘制.
+// 用法与 TextBatch 相同: 每帧 begin(), addText(), draw().
+class TextLayout{
+public:
+    TextLayout();
+
+    // 创建GL缓冲(需要GL上下文)
+    void create();
+    void begin();
+    void addText(FontsManager &fonts, const std::string &text, float x, float y, float scale, const glm::vec3 &color);
+    // 不构造 std::string 的版本(配合字符串常量和 TextBuffer 使用)
+    void addText(FontsManager &fonts, const char *text, float x, float y, float scale, const glm::vec3 &color);
+    void addText(FontsManager &fonts, const char *text, size_t length, float x, float y, float scale, const glm::vec3 &color);
+    // 有变化时重新排版上传, 然后绘制
+    void draw(Shader &shader, const glm::mat4 &projection);
+    void release();
+
+    // 累计重新排版的次数
+    int rebuilds() const { return rebuildCount; }
+    // 最近一次 draw 的统计(没有重新排版时上传量为0)
+    size_t uploadedBytes() const { return lastUploadBytes; }
+    int drawCalls() const { return batch.drawCalls(); }
+
+private:
+    struct Run{
+        FontsManager *fonts;
+        std::string text;
+        float x, y, scale;
+        glm::vec3 color;
+        unsigned int generation;    // 排版时字体的淘汰计数
+    };
+    std::vector<Run> runs;
+    size_t runCount;    // 本帧已提交的行数
+    bool dirty;
+    int rebuildCount;
+    size_t lastUploadBytes;
+    TextBatch batch;
+};
+
+#endif /* textLayout_hpp */
@@ -0,0 +1,51 @@
+//
+//  utf8.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/20.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "utf8.hpp"
+
+static const uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+uint32_t utf8Next(const char *&p, const char *end){
+    const unsigned char *s = (const unsigned char *)p;
+    unsigned char lead = s[0];
+    if (lead < 0x80) {
+        p++;
+        return lead;
+    }
+
+    int length;
+    uint32_t codepoint, minimum;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2; codepoint = lead & 0x1F; minimum = 0x80;
+    }else if ((lead & 0xF0) == 0xE0) {
+        length = 3; codepoint = lead & 0x0F; minimum = 0x800;
+    }else if ((lead & 0xF8) == 0xF0) {
+        length = 4; codepoint = lead & 0x07; minimum = 0x10000;
+    }else{
+        p++;
+        return REPLACEMENT_CHARACTER;
+    }
+    if (end - p < length) {
+        p++;
+        return REPLACEMENT_CHARACTER;
+    }
+    for (int i = 1; i < length; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            p++;
+            return REPLACEMENT_CHARACTER;
+        }
+        codepoint = (codepoint << 6) | (s[i] & 0x3F);
+    }
+    // 拒绝过长编码、代理区和超出 Unicode 范围的值
+    if (codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        p++;
+        return REPLACEMENT_CHARACTER;
+    }
+    p += length;
+    return codepoint;
+}
@@ -0,0 +1,17 @@
+//
+//  utf8.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/20.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <stdint.h>
+
+// 解码 [p, end) 中的下一个 UTF-8 字符并前移 p, 非法序列返回 U+FFFD 并跳过一个字节
+uint32_t utf8Next(const char *&p, const char *end);
+
+#endif /* utf8_hpp */
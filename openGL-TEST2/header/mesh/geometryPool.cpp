@@ -0,0 +1,219 @@
+//
+//  geometryPool.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/31.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "geometryPool.hpp"
+#include "meshOptimizer.hpp"
+#include "meshlet.hpp"
+
+using namespace std;
+
+GeometryPool::GeometryPool() : elementType(GL_UNSIGNED_INT), VAO(0), VBO(0), EBO(0),
+    vertexUsed(0), vertexCapacity(0), indexUsed(0), indexCapacity(0){
+    format.positionType = GL_FLOAT;
+    format.texCoordType = GL_UNSIGNED_SHORT;
+    format.stride = 0;
+    format.normalOffset = format.texCoordOffset = 0;
+}
+
+void GeometryPool::create(bool halfPosition, GLenum texCoordType, GLenum indexType, size_t vertexCapacity, size_t indexCapacity){
+    release();
+    // 没有顶点时 packVertices 只算出格式
+    PackedVertices empty;
+    packVertices(NULL, 0, 8, 3, 6, halfPosition, empty, texCoordType);
+    format = empty.format;
+    elementType = indexType;
+
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexCapacity * format.stride, NULL, GL_STATIC_DRAW);
+    format.setup();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCapacity * indexSize(elementType), NULL, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    this->vertexCapacity = vertexCapacity;
+    this->indexCapacity = indexCapacity;
+}
+
+bool GeometryPool::add(const float *vertices, size_t vertexCount, int stride, const unsigned int *indices, size_t indexCount, GeometryRange &range, GLenum mode){
+    if (!allocate(vertexCount, indexCount, range, mode))
+        return false;
+    PackedVertices packed;
+    packVertices(vertices, vertexCount, stride, 3, 6, format.positionType == GL_HALF_FLOAT, packed, format.texCoordType);
+    vector<unsigned char> indexData;
+    appendIndices(indices, indexCount, elementType, indexData);
+    writeVertices(range, 0, &packed.data[0], vertexCount);
+    writeIndices(range, 0, &indexData[0], indexCount);
+    return true;
+}
+
+bool GeometryPool::allocate(size_t vertexCount, size_t indexCount, GeometryRange &range, GLenum mode){
+    range.mode = mode;
+    range.baseVertex = 0;
+    range.firstIndex = 0;
+    range.indexCount = range.vertexCount = 0;
+    if (VAO == 0 || vertexCount == 0 || indexCount == 0)
+        return false;
+    bool strips = mode == GL_TRIANGLE_STRIP;
+    if (elementType == GL_UNSIGNED_SHORT && indexTypeFor(vertexCount, strips) != GL_UNSIGNED_SHORT) {
+        cout << "ERROR::GEOMETRY_POOL: Mesh has too many vertices for 16-bit indices: " << vertexCount << endl;
+        return false;
+    }
+    reserve(vertexUsed + vertexCount, indexUsed + indexCount);
+    range.baseVertex = (GLint)vertexUsed;
+    range.firstIndex = indexUsed;
+    range.indexCount = (GLsizei)indexCount;
+    range.vertexCount = (GLsizei)vertexCount;
+    vertexUsed += vertexCount;
+    indexUsed += indexCount;
+    return true;
+}
+
+void GeometryPool::writeVertices(const GeometryRange &range, size_t first, const void *data, size_t count){
+    if (count == 0)
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, (range.baseVertex + first) * format.stride, count * format.stride, data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GeometryPool::writeIndices(const GeometryRange &range, size_t first, const void *data, size_t count){
+    if (count == 0)
+        return;
+    // EBO 绑定在VAO上, 先绑定VAO再更新
+    glBindVertexArray(VAO);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (range.firstIndex + first) * indexSize(elementType), count * indexSize(elementType), data);
+    glBindVertexArray(0);
+}
+
+bool GeometryPool::addTriangles(const float *vertices, size_t vertexCount, int stride, GeometryRange &range){
+    if (vertexCount == 0)
+        return add(NULL, 0, stride, NULL, 0, range);
+    vector<float> unique(vertexCount * stride);
+    vector<unsigned int> indices(vertexCount);
+    size_t uniqueCount = generateIndices(vertices, vertexCount, stride, &unique[0], &indices[0]);
+    uniqueCount = optimizeMesh(&unique[0], uniqueCount, stride, &indices[0], indices.size());
+    return add(&unique[0], uniqueCount, stride, &indices[0], indices.size(), range);
+}
+
+void GeometryPool::reserve(size_t vertices, size_t indices){
+    if (vertices > vertexCapacity) {
+        size_t capacity = max(vertexCapacity, (size_t)1024);
+        while (capacity < vertices)
+            capacity *= 2;
+        VBO = grow(VBO, vertexUsed * format.stride, capacity * format.stride);
+        vertexCapacity = capacity;
+        // 属性指针记录的是旧缓冲, 重新设置
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        format.setup();
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    if (indices > indexCapacity) {
+        size_t capacity = max(indexCapacity, (size_t)4096);
+        while (capacity < indices)
+            capacity *= 2;
+        EBO = grow(EBO, indexUsed * indexSize(elementType), capacity * indexSize(elementType));
+        indexCapacity = capacity;
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBindVertexArray(0);
+    }
+}
+
+GLuint GeometryPool::grow(GLuint buffer, size_t used, size_t bytes){
+    GLuint grown;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, bytes, NULL, GL_STATIC_DRAW);
+    if (used > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+    return grown;
+}
+
+void GeometryPool::bind() const{
+    glBindVertexArray(VAO);
+}
+
+void GeometryPool::draw(const GeometryRange &range) const{
+    if (range.indexCount == 0)
+        return;
+    if (range.mode == GL_TRIANGLE_STRIP) {
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(restartIndexFor(elementType));
+    }
+    glDrawElementsBaseVertex(range.mode, range.indexCount, elementType, (void*)(range.firstIndex * indexSize(elementType)), range.baseVertex);
+    if (range.mode == GL_TRIANGLE_STRIP)
+        glDisable(GL_PRIMITIVE_RESTART);
+}
+
+void GeometryPool::drawMulti(const GeometryRange *ranges, int count) const{
+    // 连续的同一图元类型的 range 合成一次提交, 三角形带按 draw() 的方式打开图元重启
+    for (int first = 0; first < count;) {
+        GLenum mode = ranges[first].mode;
+        int last = first + 1;
+        while (last < count && ranges[last].mode == mode)
+            last++;
+        multiCounts.clear();
+        multiOffsets.clear();
+        multiBaseVertices.clear();
+        for (int i = first; i < last; i++) {
+            if (ranges[i].indexCount == 0)
+                continue;
+            multiCounts.push_back(ranges[i].indexCount);
+            multiOffsets.push_back((const GLvoid *)(ranges[i].firstIndex * indexSize(elementType)));
+            multiBaseVertices.push_back(ranges[i].baseVertex);
+        }
+        if (!multiCounts.empty()) {
+            if (mode == GL_TRIANGLE_STRIP) {
+                glEnable(GL_PRIMITIVE_RESTART);
+                glPrimitiveRestartIndex(restartIndexFor(elementType));
+            }
+            glMultiDrawElementsBaseVertex(mode, &multiCounts[0], elementType, (GLvoid *const *)&multiOffsets[0],
+                                          (GLsizei)multiCounts.size(), &multiBaseVertices[0]);
+            if (mode == GL_TRIANGLE_STRIP)
+                glDisable(GL_PRIMITIVE_RESTART);
+        }
+        first = last;
+    }
+}
+
+size_t GeometryPool::drawCulled(const GeometryRange &range, const vector<Meshlet> &meshlets, const MeshletCuller &culler) const{
+    if (meshlets.empty()) {
+        draw(range);
+        return 0;
+    }
+    visible.clear();
+    size_t count = cullMeshlets(meshlets, range, culler, visible);
+    if (visible.size() == 1)
+        draw(visible[0]);
+    else
+        drawMulti(visible.empty() ? NULL : &visible[0], (int)visible.size());
+    return count;
+}
+
+void GeometryPool::release(){
+    if (VAO != 0)
+        glDeleteVertexArrays(1, &VAO);
+    if (VBO != 0)
+        glDeleteBuffers(1, &VBO);
+    if (EBO != 0)
+        glDeleteBuffers(1, &EBO);
+    VAO = VBO = EBO = 0;
+    vertexUsed = vertexCapacity = 0;
+    indexUsed = indexCapacity = 0;
+}
@@ -0,0 +1,88 @@
+//
+//  geometryPool.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/31.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include <iostream>
+#include <vector>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "vertexFormat.hpp"
+
+struct Meshlet;
+struct MeshletCuller;
+
+// 一个网格在池中的位置, 用 glDrawElementsBaseVertex 绘制
+struct GeometryRange{
+    GLenum mode;            // GL_TRIANGLES 或 GL_TRIANGLE_STRIP(带图元重启)
+    GLint baseVertex;
+    size_t firstIndex;      // 按池的索引类型计
+    GLsizei indexCount;
+    GLsizei vertexCount;
+};
+
+// 同一种顶点格式的静态网格共用一个VAO/VBO/EBO: 网格依次追加到缓冲末尾, 空间不够时按2倍扩容
+// (旧内容用 glCopyBufferSubData 在显存中拷贝). 索引相对于各自网格的第一个顶点,
+// 所以 16 位索引只要求单个网格不超过 65536 个顶点. 一个 pass 只需 bind 一次.
+class GeometryPool{
+public:
+    GeometryPool();
+
+    // 格式: 位置是否用 half, 纹理坐标类型(GL_UNSIGNED_SHORT 只能放 [0,1], GL_HALF_FLOAT 可放重复贴图),
+    // 索引类型 GL_UNSIGNED_SHORT / GL_UNSIGNED_INT; capacity 为初始容量(需要GL上下文)
+    void create(bool halfPosition, GLenum texCoordType, GLenum indexType, size_t vertexCapacity = 64 * 1024, size_t indexCapacity = 256 * 1024);
+    // 加入交错 float 顶点(位置(3) 法线(3) 纹理坐标(2) 在前, stride 个 float 一个)与索引;
+    // mode 为 GL_TRIANGLE_STRIP 时 indices 中的 MESH_RESTART_INDEX 为图元重启标记
+    bool add(const float *vertices, size_t vertexCount, int stride, const unsigned int *indices, size_t indexCount, GeometryRange &range, GLenum mode = GL_TRIANGLES);
+    // 没有索引的三角形列表, 先合并相同的顶点并用 optimizeMesh 重排再加入
+    bool addTriangles(const float *vertices, size_t vertexCount, int stride, GeometryRange &range);
+    // 只分配空间, 数据之后用 writeVertices / writeIndices 分批写入(已经按 vertexFormat() 压缩好的数据)
+    bool allocate(size_t vertexCount, size_t indexCount, GeometryRange &range, GLenum mode = GL_TRIANGLES);
+    // 写入 range 中从 first 开始的 count 个顶点 / 索引(索引按 indexType() 存放)
+    void writeVertices(const GeometryRange &range, size_t first, const void *data, size_t count);
+    void writeIndices(const GeometryRange &range, size_t first, const void *data, size_t count);
+
+    // 绑定池的VAO, 之后的 draw 不再切换VAO
+    void bind() const;
+    void draw(const GeometryRange &range) const;
+    // 一次提交多个网格(glMultiDrawElementsBaseVertex), 各网格共用同一组 uniform; 图元类型不同的相邻 range 分开提交
+    void drawMulti(const GeometryRange *ranges, int count) const;
+    // 按簇剔除后绘制 range(三角形列表), meshlets 为空时整体绘制; 返回画出的簇数
+    size_t drawCulled(const GeometryRange &range, const std::vector<Meshlet> &meshlets, const MeshletCuller &culler) const;
+    void release();
+
+    const VertexFormat &vertexFormat() const { return format; }
+    GLenum indexType() const { return elementType; }
+    size_t vertexBytes() const { return vertexUsed * format.stride; }
+    size_t indexBytes() const { return indexUsed * indexSize(elementType); }
+
+private:
+    VertexFormat format;
+    GLenum elementType;
+    GLuint VAO, VBO, EBO;
+    size_t vertexUsed, vertexCapacity;
+    size_t indexUsed, indexCapacity;
+    // drawCulled 的可见段, 每次绘制复用
+    mutable std::vector<GeometryRange> visible;
+    // drawMulti 的参数数组, 每次绘制复用
+    mutable std::vector<GLsizei> multiCounts;
+    mutable std::vector<const GLvoid *> multiOffsets;
+    mutable std::vector<GLint> multiBaseVertices;
+
+    // 扩容到至少能放下 vertices 个顶点 / indices 个索引
+    void reserve(size_t vertices, size_t indices);
+    // 新建 bytes 大小的缓冲, 拷贝旧缓冲的前 used 字节
+    static GLuint grow(GLuint buffer, size_t used, size_t bytes);
+
+    GeometryPool(const GeometryPool &);
+    GeometryPool &operator=(const GeometryPool &);
+};
+
+#endif /* geometryPool_hpp */
@@ -0,0 +1,221 @@
+//
+//  meshCache.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/26.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "meshCache.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment){
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool MeshCache::Key::operator<(const Key &other) const{
+    if (type != other.type)
+        return type < other.type;
+    if (radius != other.radius)
+        return radius < other.radius;
+    if (params[0] != other.params[0])
+        return params[0] < other.params[0];
+    return params[1] < other.params[1];
+}
+
+MeshCache::MeshCache() : optimize(true), hits(0){
+}
+
+MeshCache::~MeshCache(){
+    release();
+}
+
+void MeshCache::setDirectory(const char *directory){
+    if (directory == NULL) {
+        this->directory.clear();
+        return;
+    }
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        cout << "ERROR::MESH_CACHE: Cannot create " << directory << endl;
+        this->directory.clear();
+        return;
+    }
+    this->directory = directory;
+}
+
+bool MeshCache::lookup(const Key &key, Entry &entry){
+    std::map<Key, Entry>::iterator it = entries.find(key);
+    if (it != entries.end()) {
+        entry = it->second;
+        return true;
+    }
+    Entry empty = {NULL, NULL, 0, {{NULL, 0}, {NULL, 0}, 0}};
+    entry = empty;
+    if (mapFile(key, entry)) {
+        hits++;
+        entries[key] = entry;
+        return true;
+    }
+    return false;
+}
+
+MeshView MeshCache::store(const Key &key, Entry &entry, const vector<float> &vertices, const vector<unsigned int> &indices){
+    MeshData *data = new MeshData;
+    data->vertices = vertices;
+    data->indices = indices;
+    if (optimize && !data->indices.empty()) {
+        // 顶点缓存 -> 重复着色 -> 顶点读取, 后一步不破坏前一步的结果
+        size_t vertexCount = optimizeMesh(&data->vertices[0], data->vertices.size() / 8, 8, &data->indices[0], data->indices.size());
+        data->vertices.resize(vertexCount * 8);
+    }
+    entry.generated = data;
+    entry.view.vertices.data = data->vertices.data();
+    entry.view.vertices.size = data->vertices.size();
+    entry.view.indices.data = data->indices.data();
+    entry.view.indices.size = data->indices.size();
+    entry.view.stride = 8;
+    save(key, entry.view);
+    entries[key] = entry;
+    return entry.view;
+}
+
+MeshView MeshCache::sphere(float radius, int sectors, int stacks){
+    Key key = {MESH_SPHERE, radius, {sectors, stacks}};
+    Entry entry;
+    if (lookup(key, entry))
+        return entry.view;
+    Sphere sphere(radius, sectors, stacks);
+    return store(key, entry, sphere.getVertices(), sphere.getIndices());
+}
+
+MeshView MeshCache::icosphere(float radius, int subdivisions){
+    Key key = {MESH_ICOSPHERE, radius, {subdivisions, 0}};
+    Entry entry;
+    if (lookup(key, entry))
+        return entry.view;
+    Icosphere icosphere(radius, subdivisions);
+    return store(key, entry, icosphere.getVertices(), icosphere.getIndices());
+}
+
+string MeshCache::pathFor(const Key &key) const{
+    char name[128];
+    if (key.type == MESH_ICOSPHERE)
+        snprintf(name, sizeof(name), "/icosphere_%g_%d.mesh", key.radius, key.params[0]);
+    else
+        snprintf(name, sizeof(name), "/sphere_%g_%d_%d.mesh", key.radius, key.params[0], key.params[1]);
+    return directory + name;
+}
+
+bool MeshCache::mapFile(const Key &key, Entry &entry) const{
+    if (directory.empty())
+        return false;
+    string path = pathFor(key);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MeshCacheHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void *mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+    const unsigned char *base = (const unsigned char *)mapped;
+    size_t length = (size_t)st.st_size;
+
+    const MeshCacheHeader &h = *(const MeshCacheHeader *)base;
+    if (memcmp(h.magic, MESH_CACHE_MAGIC, 4) != 0 || h.version != MESH_CACHE_VERSION || h.flags != (optimize ? MESH_CACHE_OPTIMIZED : 0u) ||
+        h.type != key.type || h.radius != key.radius || h.params[0] != key.params[0] || h.params[1] != key.params[1]) {
+        munmap(mapped, length);
+        return false;
+    }
+    // 数量来自文件, 先按剩余长度限制每个数量再相乘, 避免溢出后绕过检查; 不通过时按未命中处理
+    uint64_t vertexBytes = (uint64_t)h.stride * sizeof(float);
+    if (h.stride == 0 || h.verticesOffset > length || h.indicesOffset > length ||
+        h.verticesOffset % sizeof(float) != 0 || h.indicesOffset % sizeof(unsigned int) != 0 ||
+        h.vertexCount > (length - h.verticesOffset) / vertexBytes ||
+        h.indexCount > (length - h.indicesOffset) / sizeof(unsigned int)) {
+        cout << "ERROR::MESH_CACHE: Corrupted mesh cache " << path << endl;
+        munmap(mapped, length);
+        return false;
+    }
+    for (uint64_t i = 0; i < h.indexCount; i++) {
+        if (((const unsigned int *)(base + h.indicesOffset))[i] >= h.vertexCount) {
+            cout << "ERROR::MESH_CACHE: Corrupted mesh cache " << path << endl;
+            munmap(mapped, length);
+            return false;
+        }
+    }
+
+    entry.mapped = base;
+    entry.length = length;
+    entry.view.vertices.data = (const float *)(base + h.verticesOffset);
+    entry.view.vertices.size = (size_t)(h.vertexCount * h.stride);
+    entry.view.indices.data = (const unsigned int *)(base + h.indicesOffset);
+    entry.view.indices.size = (size_t)h.indexCount;
+    entry.view.stride = (int)h.stride;
+    return true;
+}
+
+bool MeshCache::save(const Key &key, const MeshView &view) const{
+    if (directory.empty())
+        return false;
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESH_CACHE_MAGIC, 4);
+    header.version = MESH_CACHE_VERSION;
+    header.type = key.type;
+    header.radius = key.radius;
+    header.params[0] = key.params[0];
+    header.params[1] = key.params[1];
+    header.stride = (uint32_t)view.stride;
+    header.flags = optimize ? MESH_CACHE_OPTIMIZED : 0;
+    header.vertexCount = view.vertexCount();
+    header.indexCount = view.indices.size;
+    header.verticesOffset = alignUp(sizeof(MeshCacheHeader), MESH_CACHE_ALIGNMENT);
+    header.indicesOffset = alignUp(header.verticesOffset + view.vertices.bytes(), MESH_CACHE_ALIGNMENT);
+
+    // 先写临时文件再改名, 正在映射的旧文件不受影响
+    string path = pathFor(key);
+    string temp = path + ".tmp";
+    FILE *file = fopen(temp.c_str(), "wb");
+    if (file == NULL) {
+        cout << "ERROR::MESH_CACHE: Cannot write " << temp << endl;
+        return false;
+    }
+    char padding[MESH_CACHE_ALIGNMENT] = {0};
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(padding, 1, header.verticesOffset - sizeof(header), file);
+    fwrite(view.vertices.data, sizeof(float), view.vertices.size, file);
+    fwrite(padding, 1, header.indicesOffset - (header.verticesOffset + view.vertices.bytes()), file);
+    fwrite(view.indices.data, sizeof(unsigned int), view.indices.size, file);
+    bool ok = ferror(file) == 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+        cout << "ERROR::MESH_CACHE: Cannot write " << path << endl;
+        unlink(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+void MeshCache::release(){
+    for (std::map<Key, Entry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+        delete it->second.generated;
+        if (it->second.mapped != NULL)
+            munmap((void *)it->second.mapped, it->second.length);
+    }
+    entries.clear();
+}
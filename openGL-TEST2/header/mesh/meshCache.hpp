@@ -0,0 +1,127 @@
+//
+//  meshCache.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/26.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <iostream>
+#include <string>
+#include <map>
+#include <stdint.h>
+
+#include "../sphere/sphere.hpp"
+#include "../sphere/icosphere.hpp"
+#include "meshOptimizer.hpp"
+
+// 网格缓存文件格式(每个网格一个文件, 文件名包含生成参数, 命中时 mmap):
+// [MeshCacheHeader][按 alignment 对齐的顶点 float x vertexCount*stride][按 alignment 对齐的索引 uint32 x indexCount]
+// 头部再保存一次生成参数, 与请求不一致时视为未命中.
+// version 3: 索引经过顶点缓存/重复着色优化, 顶点按使用顺序重排(flags 记录是否优化).
+#define MESH_CACHE_MAGIC "MESH"
+#define MESH_CACHE_VERSION 3
+#define MESH_CACHE_ALIGNMENT 64
+#define MESH_CACHE_OPTIMIZED 1
+
+struct MeshCacheHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t type;          // MeshCache::MeshType
+    float radius;
+    int32_t params[2];      // 球体: sectors, stacks; 测地线球: subdivisions, 0
+    uint32_t stride;        // 每个顶点的 float 数
+    uint32_t flags;         // MESH_CACHE_OPTIMIZED
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t verticesOffset;
+    uint64_t indicesOffset;
+};
+
+// 指向网格数据的只读区间(不拥有内存)
+template <typename T>
+struct MeshSpan{
+    const T *data;
+    size_t size;
+
+    const T *begin() const { return data; }
+    const T *end() const { return data + size; }
+    const T &operator[](size_t i) const { return data[i]; }
+    bool empty() const { return size == 0; }
+    size_t bytes() const { return size * sizeof(T); }
+};
+
+// 交错顶点(位置+法线+纹理坐标)与索引
+struct MeshView{
+    MeshSpan<float> vertices;
+    MeshSpan<unsigned int> indices;
+    int stride;             // 每个顶点的 float 数
+
+    size_t vertexCount() const { return stride > 0 ? vertices.size / stride : 0; }
+};
+
+// 生成的网格只构建一次: 相同参数再次请求时直接返回同一块内存的区间, 不做拷贝.
+// 设置了缓存目录时, 新生成的网格写成二进制文件, 下次启动直接 mmap, 不再生成.
+class MeshCache{
+public:
+    // 新生成的网格在缓存前做索引/顶点重排(默认打开), 需在第一次取网格前设置
+    bool optimize;
+    enum MeshType{
+        MESH_SPHERE = 1,
+        MESH_ICOSPHERE = 2
+    };
+
+    MeshCache();
+    ~MeshCache();
+
+    // 磁盘缓存目录(不存在时创建), 为 NULL 时只在内存中缓存
+    void setDirectory(const char *directory);
+    // 取得球体网格, 返回的区间在 release 之前一直有效
+    MeshView sphere(float radius, int sectors, int stacks);
+    // 取得测地线球网格(正二十面体细分 subdivisions 次)
+    MeshView icosphere(float radius, int subdivisions);
+    // 释放所有网格(生成的内存与映射的文件)
+    void release();
+
+    size_t size() const { return entries.size(); }
+    // 从磁盘缓存命中的次数
+    int diskHits() const { return hits; }
+
+private:
+    struct Key{
+        uint32_t type;
+        float radius;
+        int params[2];
+
+        bool operator<(const Key &other) const;
+    };
+    struct MeshData{
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+    };
+    struct Entry{
+        MeshData *generated;            // 生成的网格(从文件映射时为 NULL)
+        const unsigned char *mapped;    // 映射的缓存文件
+        size_t length;
+        MeshView view;
+    };
+    std::map<Key, Entry> entries;
+    std::string directory;
+    int hits;
+
+    // 已缓存时返回 true 并填好 view, 否则尝试映射磁盘缓存
+    bool lookup(const Key &key, Entry &entry);
+    // 新生成的网格(按需优化后)加入缓存并写盘
+    MeshView store(const Key &key, Entry &entry, const std::vector<float> &vertices, const std::vector<unsigned int> &indices);
+    std::string pathFor(const Key &key) const;
+    bool mapFile(const Key &key, Entry &entry) const;
+    bool save(const Key &key, const MeshView &view) const;
+
+    MeshCache(const MeshCache &);
+    MeshCache &operator=(const MeshCache &);
+};
+
+#endif /* meshCache_hpp */
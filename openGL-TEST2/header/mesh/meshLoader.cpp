@@ -0,0 +1,967 @@
+//
+//  meshLoader.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/4/1.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "meshLoader.hpp"
+#include "meshOptimizer.hpp"
+#include "../util/flatHashMap.hpp"
+#include "../util/hash.hpp"
+#include "../util/workerPool.hpp"
+#include "../vfs/assetPack.hpp"
+
+#include <vector>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// 每块至少分到这么多字节(OBJ)或顶点(glTF), 否则分派的开销比解析还大
+static const size_t LOADER_MIN_BYTES_PER_THREAD = 256 * 1024;
+static const size_t LOADER_MIN_VERTICES_PER_THREAD = 16 * 1024;
+
+// 在块内合并相同的顶点(按字节比较, Vertex 不能有填充), 新顶点追加到 unique, 返回块内序号.
+// 哈希相同但内容不同时顺延到下一个键
+template <typename Vertex>
+static unsigned int dedupVertex(FlatHashMap<unsigned int> &seen, vector<Vertex> &unique, const Vertex &vertex){
+    for (uint64_t hash = fnv1a64(&vertex, sizeof(vertex));; hash++) {
+        unsigned int *found = seen.find(hash);
+        if (found == NULL) {
+            unsigned int index = (unsigned int)unique.size();
+            unique.push_back(vertex);
+            seen.insert(hash, index);
+            return index;
+        }
+        if (memcmp(&unique[*found], &vertex, sizeof(vertex)) == 0)
+            return *found;
+    }
+}
+
+static void resetBounds(float bounds[6]){
+    bounds[0] = bounds[1] = bounds[2] = FLT_MAX;
+    bounds[3] = bounds[4] = bounds[5] = -FLT_MAX;
+}
+
+static void growBounds(float bounds[6], const float *position){
+    for (int k = 0; k < 3; k++) {
+        bounds[k] = min(bounds[k], position[k]);
+        bounds[k + 3] = max(bounds[k + 3], position[k]);
+    }
+}
+
+// 合并各块的包围盒, 跳过没有写出顶点的块
+template <typename Chunk>
+static void mergeBounds(float bounds[6], const vector<Chunk> &chunks){
+    for (size_t c = 0; c < chunks.size(); c++) {
+        if (chunks[c].bounds[0] > chunks[c].bounds[3])
+            continue;
+        growBounds(bounds, chunks[c].bounds);
+        growBounds(bounds, chunks[c].bounds + 3);
+    }
+}
+
+MeshLoader::MeshLoader() : status(MESH_LOAD_IDLE), threads(0), data(NULL), length(0), mapped(NULL), mappedLength(0),
+    indexType(GL_UNSIGNED_INT), vertexData(NULL), indexData(NULL), vertexCount(0), indexCount(0), verticesUploaded(0), indicesUploaded(0){
+    resetBounds(bounds);
+    memset(&format, 0, sizeof(format));
+    memset(&geometry, 0, sizeof(geometry));
+}
+
+MeshLoader::~MeshLoader(){
+    release();
+}
+
+bool MeshLoader::start(const char *path, const GeometryPool &pool, int threads){
+    release();
+    this->path = path;
+    this->threads = threads;
+    format = pool.vertexFormat();
+    indexType = pool.indexType();
+
+    // 资源包中有该文件时直接用包内的映射, 否则单独 mmap
+    AssetSpan span;
+    if (AssetPack::mounted().find(path, span)) {
+        data = span.data;
+        length = span.size;
+    }else{
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            cout << "ERROR::MESH_LOADER: Failed to open " << path << endl;
+            status = MESH_LOAD_FAILED;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            cout << "ERROR::MESH_LOADER: Empty file " << path << endl;
+            status = MESH_LOAD_FAILED;
+            return false;
+        }
+        mappedLength = (size_t)st.st_size;
+        mapped = mmap(NULL, mappedLength, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            mapped = NULL;
+            cout << "ERROR::MESH_LOADER: Failed to map " << path << endl;
+            status = MESH_LOAD_FAILED;
+            return false;
+        }
+        // 解析基本是顺序读
+        madvise(mapped, mappedLength, MADV_SEQUENTIAL);
+        data = (const unsigned char *)mapped;
+        length = mappedLength;
+    }
+
+    status = MESH_LOAD_PARSING;
+    worker = thread(&MeshLoader::parse, this);
+    return true;
+}
+
+void MeshLoader::parse(){
+    bool glb = length >= 4 && memcmp(data, "glTF", 4) == 0;
+    int count = workerThreadCount(threads);
+    bool ok = glb ? parseGlb(count) : parseObj(count);
+    // 簇的包围球和法线锥从压缩前的 float 位置算, 与池的格式无关; 此时索引和位置都已是重排后的顺序
+    if (ok)
+        buildMeshlets((const unsigned int *)indexData, indexCount, &positions[0], vertexCount, 3, clusters);
+    // 解析时索引一律按 32 位存放, 池为 16 位索引时原地压缩(写的位置总在读过的位置之前)
+    if (ok && indexType == GL_UNSIGNED_SHORT) {
+        for (size_t i = 0; i < indexCount; i++) {
+            GLuint wide;
+            memcpy(&wide, indexData + i * sizeof(GLuint), sizeof(wide));
+            GLushort narrow = (GLushort)wide;
+            memcpy(indexData + i * sizeof(GLushort), &narrow, sizeof(narrow));
+        }
+    }
+    vector<float>().swap(positions);
+    status = ok ? MESH_LOAD_UPLOADING : MESH_LOAD_FAILED;
+}
+
+bool MeshLoader::update(GeometryPool &pool, size_t uploadBudget){
+    int current = status;
+    if (current == MESH_LOAD_READY)
+        return true;
+    if (current == MESH_LOAD_FAILED && worker.joinable()) {
+        // 解析失败, 释放映射和暂存数据
+        release();
+        status = MESH_LOAD_FAILED;
+        return false;
+    }
+    if (current != MESH_LOAD_UPLOADING)
+        return false;
+    if (worker.joinable())
+        worker.join();
+
+    if (verticesUploaded == 0 && indicesUploaded == 0) {
+        const VertexFormat &target = pool.vertexFormat();
+        if (target.stride != format.stride || target.positionType != format.positionType ||
+            target.texCoordType != format.texCoordType || pool.indexType() != indexType) {
+            cout << "ERROR::MESH_LOADER: Geometry pool format changed while loading " << path << endl;
+            release();
+            status = MESH_LOAD_FAILED;
+            return false;
+        }
+        if (!pool.allocate(vertexCount, indexCount, geometry)) {
+            release();
+            status = MESH_LOAD_FAILED;
+            return false;
+        }
+    }
+
+    // 顶点在前, 索引在后, 按预算分批上传
+    size_t budget = max(uploadBudget, (size_t)format.stride);
+    if (verticesUploaded < vertexCount) {
+        size_t count = min(vertexCount - verticesUploaded, budget / format.stride);
+        pool.writeVertices(geometry, verticesUploaded, vertexData + verticesUploaded * format.stride, count);
+        verticesUploaded += count;
+        budget -= count * format.stride;
+    }
+    size_t elementSize = indexSize(indexType);
+    if (verticesUploaded == vertexCount && indicesUploaded < indexCount && budget >= elementSize) {
+        size_t count = min(indexCount - indicesUploaded, budget / elementSize);
+        pool.writeIndices(geometry, indicesUploaded, indexData + indicesUploaded * elementSize, count);
+        indicesUploaded += count;
+    }
+    if (indicesUploaded < indexCount)
+        return false;
+
+    // 全部上传后释放暂存和映射, 只保留池中的 range 和包围盒
+    GeometryRange done = geometry;
+    float box[6];
+    memcpy(box, bounds, sizeof(box));
+    vector<Meshlet> built;
+    built.swap(clusters);
+    release();
+    geometry = done;
+    memcpy(bounds, box, sizeof(box));
+    clusters.swap(built);
+    status = MESH_LOAD_READY;
+    return true;
+}
+
+void MeshLoader::release(){
+    if (worker.joinable())
+        worker.join();
+    if (mapped != NULL)
+        munmap(mapped, mappedLength);
+    mapped = NULL;
+    mappedLength = 0;
+    data = NULL;
+    length = 0;
+    delete[] vertexData;
+    delete[] indexData;
+    vertexData = indexData = NULL;
+    vertexCount = indexCount = 0;
+    vector<float>().swap(positions);
+    verticesUploaded = indicesUploaded = 0;
+    resetBounds(bounds);
+    memset(&geometry, 0, sizeof(geometry));
+    clusters.clear();
+    status = MESH_LOAD_IDLE;
+}
+
+bool MeshLoader::checkVertexCount(size_t count) const{
+    if (count == 0) {
+        cout << "ERROR::MESH_LOADER: No triangles in " << path << endl;
+        return false;
+    }
+    if (indexType == GL_UNSIGNED_SHORT && indexTypeFor(count) != GL_UNSIGNED_SHORT) {
+        cout << "ERROR::MESH_LOADER: " << path << " has too many vertices for 16-bit indices: " << count << endl;
+        return false;
+    }
+    return true;
+}
+
+bool MeshLoader::optimize(vector<unsigned int> &targets){
+    GLuint *indices = (GLuint *)indexData;
+    optimizeVertexCache(indices, indexCount, vertexCount);
+    optimizeOverdraw(indices, indexCount, &positions[0], vertexCount, 3);
+    targets.resize(vertexCount);
+    size_t used = optimizeVertexFetchRemap(&targets[0], indices, indexCount, vertexCount);
+    vector<float> reordered(used * 3);
+    for (size_t v = 0; v < vertexCount; v++)
+        if (targets[v] != MESH_UNUSED_VERTEX)
+            memcpy(&reordered[(size_t)targets[v] * 3], &positions[v * 3], 3 * sizeof(float));
+    positions.swap(reordered);
+    vertexCount = used;
+    return checkVertexCount(vertexCount);
+}
+
+// ===== Wavefront OBJ =====
+
+// 不依赖 locale, 也不会读过 end 的数字解析(文件是 mmap 的, 末尾没有 '\0')
+static const char *skipSpaces(const char *p, const char *end){
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    return p;
+}
+
+static const char *parseInt(const char *p, const char *end, int &value){
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    long long result = 0;
+    while (p < end && *p >= '0' && *p <= '9' && result < 0x7fffffff)
+        result = result * 10 + (*p++ - '0');
+    value = (int)(negative ? -result : result);
+    return p;
+}
+
+static const char *parseNumber(const char *p, const char *end, double &value){
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16};
+    p = skipSpaces(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    double mantissa = 0.0;
+    int exponent = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+        mantissa = mantissa * 10.0 + (*p++ - '0');
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            mantissa = mantissa * 10.0 + (*p++ - '0');
+            exponent--;
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        int e = 0;
+        p = parseInt(p + 1, end, e);
+        exponent += e;
+    }
+    double scale = abs(exponent) <= 16 ? powers[abs(exponent)] : pow(10.0, abs(exponent));
+    double result = exponent < 0 ? mantissa / scale : mantissa * scale;
+    value = negative ? -result : result;
+    return p;
+}
+
+static const char *parseFloat(const char *p, const char *end, float &value){
+    double number = 0.0;
+    p = parseNumber(p, end, number);
+    value = (float)number;
+    return p;
+}
+
+static const char *lineEnd(const char *p, const char *end){
+    const char *newline = (const char *)memchr(p, '\n', end - p);
+    return newline == NULL ? end : newline;
+}
+
+static bool isSpace(char c){
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// 行首的关键字: 'v' 位置, 't' 纹理坐标, 'n' 法线, 'f' 面, 0 其他(注释, o/g/s/usemtl 等)
+static char lineType(const char *p, const char *end){
+    if (end - p < 2 || !isSpace(p[1])) {
+        if (end - p >= 3 && p[0] == 'v' && (p[1] == 't' || p[1] == 'n') && isSpace(p[2]))
+            return p[1];
+        return 0;
+    }
+    return p[0] == 'v' || p[0] == 'f' ? p[0] : 0;
+}
+
+// OBJ 的一个面顶点: 位置/纹理坐标/法线的序号(从0开始, -1 表示没有)
+struct ObjCorner{
+    int32_t position;
+    int32_t texCoord;
+    int32_t normal;
+};
+
+struct ObjChunk{
+    const char *begin;
+    const char *end;
+    // 第一遍统计的数量, 以及之前各块的总数
+    size_t positions, texCoords, normals, triangles;
+    size_t positionBase, texCoordBase, normalBase, triangleBase;
+    // 第二遍合并后的顶点, 压缩前先暂存序号, 重排顶点后才知道写到哪里
+    vector<ObjCorner> unique;
+    size_t vertexBase;
+    float bounds[6];
+    bool ok;
+};
+
+bool MeshLoader::parseObj(int chunkCount){
+    const char *text = (const char *)data;
+    const char *textEnd = text + length;
+    chunkCount = max(1, min(chunkCount, (int)(length / LOADER_MIN_BYTES_PER_THREAD) + 1));
+
+    // 在换行处切块, 每块都从行首开始
+    vector<ObjChunk> chunks(chunkCount);
+    for (int c = 0; c < chunkCount; c++) {
+        const char *begin = text + length * c / chunkCount;
+        if (c > 0)
+            begin = min(lineEnd(begin, textEnd) + 1, textEnd);
+        chunks[c].begin = c > 0 ? max(begin, chunks[c - 1].begin) : text;
+        if (c > 0)
+            chunks[c - 1].end = chunks[c].begin;
+        chunks[c].end = textEnd;
+    }
+
+    // 1. 统计每块的 v/vt/vn 行数和三角形数(多边形按扇形拆分)
+    WorkerPool::shared().run(chunkCount, [&](int c){
+        ObjChunk &chunk = chunks[c];
+        chunk.positions = chunk.texCoords = chunk.normals = chunk.triangles = 0;
+        for (const char *p = chunk.begin; p < chunk.end;) {
+            const char *eol = lineEnd(p, chunk.end);
+            p = skipSpaces(p, eol);
+            switch (lineType(p, eol)) {
+                case 'v': chunk.positions++; break;
+                case 't': chunk.texCoords++; break;
+                case 'n': chunk.normals++; break;
+                case 'f': {
+                    int corners = 0;
+                    for (const char *q = p + 1; q < eol;) {
+                        while (q < eol && isSpace(*q))
+                            q++;
+                        if (q == eol)
+                            break;
+                        corners++;
+                        while (q < eol && !isSpace(*q))
+                            q++;
+                    }
+                    if (corners >= 3)
+                        chunk.triangles += corners - 2;
+                    break;
+                }
+            }
+            p = eol + 1;
+        }
+    });
+    size_t positionCount = 0, texCoordCount = 0, normalCount = 0, triangleCount = 0;
+    for (int c = 0; c < chunkCount; c++) {
+        chunks[c].positionBase = positionCount;
+        chunks[c].texCoordBase = texCoordCount;
+        chunks[c].normalBase = normalCount;
+        chunks[c].triangleBase = triangleCount;
+        positionCount += chunks[c].positions;
+        texCoordCount += chunks[c].texCoords;
+        normalCount += chunks[c].normals;
+        triangleCount += chunks[c].triangles;
+    }
+    if (triangleCount == 0) {
+        cout << "ERROR::MESH_LOADER: No triangles in " << path << endl;
+        return false;
+    }
+
+    // 2. 解析属性到各自的位置; 面顶点在块内合并, 块内序号先写进索引暂存区
+    vector<float> sourcePositions(positionCount * 3), texCoords(texCoordCount * 2), normals(normalCount * 3);
+    indexCount = triangleCount * 3;
+    indexData = new unsigned char[indexCount * sizeof(GLuint)];
+    GLuint *indices = (GLuint *)indexData;
+    WorkerPool::shared().run(chunkCount, [&](int c){
+        ObjChunk &chunk = chunks[c];
+        chunk.ok = true;
+        size_t position = chunk.positionBase, texCoord = chunk.texCoordBase, normal = chunk.normalBase;
+        size_t index = chunk.triangleBase * 3;
+        FlatHashMap<unsigned int> seen;
+        for (const char *p = chunk.begin; p < chunk.end && chunk.ok;) {
+            const char *eol = lineEnd(p, chunk.end);
+            p = skipSpaces(p, eol);
+            switch (lineType(p, eol)) {
+                case 'v': {
+                    const char *q = p + 1;
+                    for (int k = 0; k < 3; k++)
+                        q = parseFloat(q, eol, sourcePositions[position * 3 + k]);
+                    position++;
+                    break;
+                }
+                case 't': {
+                    const char *q = p + 2;
+                    for (int k = 0; k < 2; k++)
+                        q = parseFloat(q, eol, texCoords[texCoord * 2 + k]);
+                    texCoord++;
+                    break;
+                }
+                case 'n': {
+                    const char *q = p + 2;
+                    for (int k = 0; k < 3; k++)
+                        q = parseFloat(q, eol, normals[normal * 3 + k]);
+                    normal++;
+                    break;
+                }
+                case 'f': {
+                    // v, v/vt, v//vn, v/vt/vn; 负数为相对当前已出现的数量
+                    unsigned int first = 0, previous = 0;
+                    int corners = 0;
+                    for (const char *q = p + 1; q < eol && chunk.ok;) {
+                        while (q < eol && isSpace(*q))
+                            q++;
+                        if (q == eol)
+                            break;
+                        int values[3] = {0, 0, 0};
+                        for (int k = 0; k < 3 && q < eol && !isSpace(*q); k++) {
+                            if (*q != '/')
+                                q = parseInt(q, eol, values[k]);
+                            if (q < eol && *q == '/')
+                                q++;
+                        }
+                        while (q < eol && !isSpace(*q))
+                            q++;
+                        size_t counts[3] = {position, texCoord, normal};
+                        size_t totals[3] = {positionCount, texCoordCount, normalCount};
+                        int32_t resolved[3];
+                        for (int k = 0; k < 3; k++) {
+                            long long index = values[k] > 0 ? values[k] - 1 : (values[k] < 0 ? (long long)counts[k] + values[k] : -1);
+                            if (index >= (long long)totals[k] || index < -1 || (k == 0 && index < 0))
+                                chunk.ok = false;
+                            resolved[k] = (int32_t)index;
+                        }
+                        if (!chunk.ok)
+                            break;
+                        ObjCorner corner = {resolved[0], resolved[1], resolved[2]};
+                        unsigned int vertex = dedupVertex(seen, chunk.unique, corner);
+                        // 扇形拆分: (0, i-1, i)
+                        if (corners == 0)
+                            first = vertex;
+                        else if (corners >= 2) {
+                            indices[index++] = first;
+                            indices[index++] = previous;
+                            indices[index++] = vertex;
+                        }
+                        previous = vertex;
+                        corners++;
+                    }
+                    break;
+                }
+            }
+            p = eol + 1;
+        }
+    });
+    vertexCount = 0;
+    for (int c = 0; c < chunkCount; c++) {
+        if (!chunks[c].ok) {
+            cout << "ERROR::MESH_LOADER: Invalid face index in " << path << endl;
+            return false;
+        }
+        chunks[c].vertexBase = vertexCount;
+        vertexCount += chunks[c].unique.size();
+    }
+
+    // 3. 收集合并后顶点的位置, 索引加上块的顶点偏移
+    positions.resize(vertexCount * 3);
+    WorkerPool::shared().run(chunkCount, [&](int c){
+        ObjChunk &chunk = chunks[c];
+        for (size_t i = 0; i < chunk.unique.size(); i++) {
+            const ObjCorner &corner = chunk.unique[i];
+            memcpy(&positions[(chunk.vertexBase + i) * 3], &sourcePositions[(size_t)corner.position * 3], 3 * sizeof(float));
+        }
+        if (chunk.vertexBase > 0) {
+            for (size_t i = chunk.triangleBase * 3; i < (chunk.triangleBase + chunk.triangles) * 3; i++)
+                indices[i] += (unsigned int)chunk.vertexBase;
+        }
+    });
+
+    // 4. 重排三角形和顶点, 各块再把合并后的顶点压缩写到重排后的位置
+    vector<unsigned int> targets;
+    if (!optimize(targets))
+        return false;
+    vertexData = new unsigned char[vertexCount * format.stride];
+    WorkerPool::shared().run(chunkCount, [&](int c){
+        ObjChunk &chunk = chunks[c];
+        resetBounds(chunk.bounds);
+        for (size_t i = 0; i < chunk.unique.size(); i++) {
+            unsigned int target = targets[chunk.vertexBase + i];
+            if (target == MESH_UNUSED_VERTEX)
+                continue;
+            const ObjCorner &corner = chunk.unique[i];
+            const float *position = &sourcePositions[(size_t)corner.position * 3];
+            const float *texCoord = corner.texCoord >= 0 ? &texCoords[(size_t)corner.texCoord * 2] : NULL;
+            const float *normal = corner.normal >= 0 ? &normals[(size_t)corner.normal * 3] : NULL;
+            packVertex(format, position, normal, texCoord, vertexData + (size_t)target * format.stride);
+            growBounds(chunk.bounds, position);
+        }
+    });
+    mergeBounds(bounds, chunks);
+    return true;
+}
+
+// ===== glTF 2.0 二进制(.glb) =====
+
+// 只读的 JSON 树, 所有节点放在一个数组里, 子节点用链表串起来; 字符串不转义, 指向原文
+struct JsonValue{
+    char type;              // 'n' null, 'b' bool, '0' 数字, 's' 字符串, '[' 数组, '{' 对象
+    double number;
+    const char *text;       // 字符串内容
+    size_t textLength;
+    const char *key;        // 作为对象成员时的键
+    size_t keyLength;
+    int firstChild;
+    int next;
+};
+
+class JsonParser{
+public:
+    JsonParser(const char *text, size_t length) : p(text), end(text + length) {}
+
+    int parse(vector<JsonValue> &nodes){
+        return value(nodes, 0);
+    }
+
+private:
+    const char *p;
+    const char *end;
+
+    void skip(){
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            p++;
+    }
+
+    bool parseString(const char *&text, size_t &length){
+        if (p >= end || *p != '"')
+            return false;
+        text = ++p;
+        while (p < end && *p != '"')
+            p += *p == '\\' ? 2 : 1;
+        if (p >= end)
+            return false;
+        length = p++ - text;
+        return true;
+    }
+
+    int value(vector<JsonValue> &nodes, int depth){
+        skip();
+        if (p >= end || depth > 64)
+            return -1;
+        int index = (int)nodes.size();
+        JsonValue node = {0, 0.0, NULL, 0, NULL, 0, -1, -1};
+        nodes.push_back(node);
+        char c = *p;
+        if (c == '{' || c == '[') {
+            nodes[index].type = c;
+            p++;
+            int last = -1;
+            for (;;) {
+                skip();
+                if (p < end && *p == (c == '{' ? '}' : ']')) {
+                    p++;
+                    return index;
+                }
+                const char *key = NULL;
+                size_t keyLength = 0;
+                if (c == '{') {
+                    if (!parseString(key, keyLength))
+                        return -1;
+                    skip();
+                    if (p >= end || *p++ != ':')
+                        return -1;
+                }
+                int child = value(nodes, depth + 1);
+                if (child < 0)
+                    return -1;
+                nodes[child].key = key;
+                nodes[child].keyLength = keyLength;
+                if (last < 0)
+                    nodes[index].firstChild = child;
+                else
+                    nodes[last].next = child;
+                last = child;
+                skip();
+                if (p < end && *p == ',')
+                    p++;
+            }
+        }
+        if (c == '"') {
+            nodes[index].type = 's';
+            return parseString(nodes[index].text, nodes[index].textLength) ? index : -1;
+        }
+        if (c == 't' || c == 'f' || c == 'n') {
+            nodes[index].type = c == 'n' ? 'n' : 'b';
+            nodes[index].number = c == 't' ? 1.0 : 0.0;
+            while (p < end && *p >= 'a' && *p <= 'z')
+                p++;
+            return index;
+        }
+        double number = 0.0;
+        const char *start = p;
+        p = parseNumber(p, end, number);
+        if (p == start)
+            return -1;
+        nodes[index].type = '0';
+        nodes[index].number = number;
+        return index;
+    }
+};
+
+static int jsonMember(const vector<JsonValue> &nodes, int object, const char *key){
+    if (object < 0 || nodes[object].type != '{')
+        return -1;
+    size_t length = strlen(key);
+    for (int child = nodes[object].firstChild; child >= 0; child = nodes[child].next)
+        if (nodes[child].keyLength == length && memcmp(nodes[child].key, key, length) == 0)
+            return child;
+    return -1;
+}
+
+static int jsonElement(const vector<JsonValue> &nodes, int array, int element){
+    if (array < 0 || nodes[array].type != '[' || element < 0)
+        return -1;
+    int child = nodes[array].firstChild;
+    for (int i = 0; i < element && child >= 0; i++)
+        child = nodes[child].next;
+    return child;
+}
+
+static double jsonNumber(const vector<JsonValue> &nodes, int value, double fallback){
+    return value >= 0 && nodes[value].type == '0' ? nodes[value].number : fallback;
+}
+
+// 非负整数: 没有该成员时取 fallback; 不是数字、不是整数、为负或超过 limit 时返回 false(先检查再转换, 避免 NaN 或超大值转整数)
+static bool jsonSize(const vector<JsonValue> &nodes, int value, size_t fallback, size_t limit, size_t &result){
+    if (value < 0) {
+        result = fallback;
+        return true;
+    }
+    double number = nodes[value].number;
+    if (nodes[value].type != '0' || !(number >= 0.0) || number > (double)limit || number != floor(number))
+        return false;
+    result = (size_t)number;
+    return true;
+}
+
+// 数组下标, 没有或无效时为 -1
+static int jsonIndex(const vector<JsonValue> &nodes, int value){
+    size_t index = 0;
+    if (value < 0 || !jsonSize(nodes, value, 0, INT_MAX, index))
+        return -1;
+    return (int)index;
+}
+
+static bool jsonEquals(const vector<JsonValue> &nodes, int value, const char *text){
+    return value >= 0 && nodes[value].type == 's' && nodes[value].textLength == strlen(text) &&
+        memcmp(nodes[value].text, text, nodes[value].textLength) == 0;
+}
+
+// glTF accessor 指向 BIN 块中的一段数据
+struct GltfAccessor{
+    const unsigned char *data;
+    size_t count;
+    size_t stride;
+    int componentType;      // 5120 byte, 5121 ubyte, 5122 short, 5123 ushort, 5125 uint, 5126 float
+    int components;
+    bool normalized;
+};
+
+static size_t componentSize(int componentType){
+    switch (componentType) {
+        case 5120: case 5121: return 1;
+        case 5122: case 5123: return 2;
+        case 5125: case 5126: return 4;
+    }
+    return 0;
+}
+
+static bool gltfAccessor(const vector<JsonValue> &nodes, int root, int index, const unsigned char *bin, size_t binLength, GltfAccessor &accessor){
+    int node = jsonElement(nodes, jsonMember(nodes, root, "accessors"), index);
+    if (node < 0)
+        return false;
+    int view = jsonElement(nodes, jsonMember(nodes, root, "bufferViews"), jsonIndex(nodes, jsonMember(nodes, node, "bufferView")));
+    if (view < 0 || jsonNumber(nodes, jsonMember(nodes, view, "buffer"), 0) != 0)
+        return false;
+    int type = jsonMember(nodes, node, "type");
+    accessor.components = jsonEquals(nodes, type, "SCALAR") ? 1 : jsonEquals(nodes, type, "VEC2") ? 2 :
+        jsonEquals(nodes, type, "VEC3") ? 3 : jsonEquals(nodes, type, "VEC4") ? 4 : 0;
+    accessor.normalized = jsonNumber(nodes, jsonMember(nodes, node, "normalized"), 0) != 0;
+    // 偏移、长度和数量都不会超过 BIN 块的长度
+    size_t componentType = 0, viewOffset = 0, viewLength = 0, offset = 0;
+    if (!jsonSize(nodes, jsonMember(nodes, node, "componentType"), 0, 0xFFFF, componentType) ||
+        !jsonSize(nodes, jsonMember(nodes, node, "count"), 0, binLength, accessor.count) ||
+        !jsonSize(nodes, jsonMember(nodes, view, "byteOffset"), 0, binLength, viewOffset) ||
+        !jsonSize(nodes, jsonMember(nodes, view, "byteLength"), 0, binLength, viewLength) ||
+        !jsonSize(nodes, jsonMember(nodes, node, "byteOffset"), 0, binLength, offset))
+        return false;
+    accessor.componentType = (int)componentType;
+    size_t elementSize = componentSize(accessor.componentType) * accessor.components;
+    // glTF 规定 byteStride 在 4 到 252 之间
+    if (!jsonSize(nodes, jsonMember(nodes, view, "byteStride"), elementSize, 252, accessor.stride))
+        return false;
+    // 先减后比, 不会溢出
+    if (elementSize == 0 || accessor.count == 0 || accessor.stride < elementSize ||
+        viewLength > binLength - viewOffset || offset > viewLength || elementSize > viewLength - offset ||
+        accessor.count - 1 > (viewLength - offset - elementSize) / accessor.stride)
+        return false;
+    accessor.data = bin + viewOffset + offset;
+    return true;
+}
+
+// 读取第 i 个元素的前 count 个分量, 整数按 normalized 归一化
+static void gltfRead(const GltfAccessor &accessor, size_t i, float *out, int count){
+    const unsigned char *element = accessor.data + i * accessor.stride;
+    for (int k = 0; k < count; k++) {
+        float value = 0.0f;
+        if (k < accessor.components) {
+            switch (accessor.componentType) {
+                case 5126: memcpy(&value, element + k * 4, 4); break;
+                case 5121: value = element[k] / (accessor.normalized ? 255.0f : 1.0f); break;
+                case 5123: { uint16_t v; memcpy(&v, element + k * 2, 2); value = v / (accessor.normalized ? 65535.0f : 1.0f); break; }
+                case 5120: value = max((int8_t)element[k] / (accessor.normalized ? 127.0f : 1.0f), -1.0f); break;
+                case 5122: { int16_t v; memcpy(&v, element + k * 2, 2); value = max(v / (accessor.normalized ? 32767.0f : 1.0f), -1.0f); break; }
+            }
+        }
+        out[k] = value;
+    }
+}
+
+static unsigned int gltfIndex(const GltfAccessor &accessor, size_t i){
+    const unsigned char *element = accessor.data + i * accessor.stride;
+    if (accessor.componentType == 5121)
+        return element[0];
+    if (accessor.componentType == 5123) {
+        uint16_t v;
+        memcpy(&v, element, 2);
+        return v;
+    }
+    uint32_t v;
+    memcpy(&v, element, 4);
+    return v;
+}
+
+struct GltfPrimitive{
+    GltfAccessor position, normal, texCoord, indices;
+    bool hasNormal, hasTexCoord, hasIndices;
+    size_t vertexBase;      // 在所有图元的源顶点中的起点
+    size_t indexBase;
+};
+
+// 合并前读出的顶点; 没有法线或纹理坐标的图元用 NaN 标记, 合并时与 0 区分开
+struct GltfVertex{
+    float position[3];
+    float normal[3];
+    float texCoord[2];
+};
+
+struct GltfChunk{
+    size_t first, last;     // 负责的源顶点区间
+    vector<GltfVertex> unique;  // 合并后的顶点, 重排顶点后再压缩
+    size_t vertexBase;
+    float bounds[6];
+};
+
+bool MeshLoader::parseGlb(int chunkCount){
+    // [header 12字节][JSON 块][BIN 块], 块头为 长度(4) + 类型(4)
+    uint32_t header[3], jsonHeader[2], binHeader[2] = {0, 0};
+    if (length < 20) {
+        cout << "ERROR::MESH_LOADER: Truncated glTF " << path << endl;
+        return false;
+    }
+    memcpy(header, data, sizeof(header));
+    memcpy(jsonHeader, data + 12, sizeof(jsonHeader));
+    if (header[1] != 2 || jsonHeader[1] != 0x4E4F534A || 20 + (size_t)jsonHeader[0] > length) {
+        cout << "ERROR::MESH_LOADER: Unsupported glTF " << path << endl;
+        return false;
+    }
+    size_t binOffset = 20 + jsonHeader[0];
+    if (binOffset + 8 <= length)
+        memcpy(binHeader, data + binOffset, sizeof(binHeader));
+    const unsigned char *bin = data + binOffset + 8;
+    size_t binLength = binHeader[1] == 0x004E4942 && binOffset + 8 + binHeader[0] <= length ? binHeader[0] : 0;
+
+    vector<JsonValue> nodes;
+    JsonParser parser((const char *)data + 20, jsonHeader[0]);
+    int root = parser.parse(nodes);
+    if (root < 0) {
+        cout << "ERROR::MESH_LOADER: Invalid glTF JSON in " << path << endl;
+        return false;
+    }
+
+    // 收集所有三角形图元
+    vector<GltfPrimitive> primitives;
+    size_t sourceCount = 0;
+    indexCount = 0;
+    int meshes = jsonMember(nodes, root, "meshes");
+    for (int mesh = jsonElement(nodes, meshes, 0); mesh >= 0; mesh = nodes[mesh].next) {
+        int list = jsonMember(nodes, mesh, "primitives");
+        for (int node = jsonElement(nodes, list, 0); node >= 0; node = nodes[node].next) {
+            if (jsonNumber(nodes, jsonMember(nodes, node, "mode"), 4) != 4)
+                continue;
+            int attributes = jsonMember(nodes, node, "attributes");
+            GltfPrimitive primitive;
+            int position = jsonIndex(nodes, jsonMember(nodes, attributes, "POSITION"));
+            int normal = jsonIndex(nodes, jsonMember(nodes, attributes, "NORMAL"));
+            int texCoord = jsonIndex(nodes, jsonMember(nodes, attributes, "TEXCOORD_0"));
+            int indices = jsonIndex(nodes, jsonMember(nodes, node, "indices"));
+            if (!gltfAccessor(nodes, root, position, bin, binLength, primitive.position)) {
+                cout << "ERROR::MESH_LOADER: Invalid POSITION accessor in " << path << endl;
+                return false;
+            }
+            primitive.hasNormal = gltfAccessor(nodes, root, normal, bin, binLength, primitive.normal) && primitive.normal.count == primitive.position.count;
+            primitive.hasTexCoord = gltfAccessor(nodes, root, texCoord, bin, binLength, primitive.texCoord) && primitive.texCoord.count == primitive.position.count;
+            primitive.hasIndices = jsonMember(nodes, node, "indices") >= 0;
+            if (primitive.hasIndices && (!gltfAccessor(nodes, root, indices, bin, binLength, primitive.indices) ||
+                primitive.indices.components != 1 || primitive.indices.componentType == 5120 ||
+                primitive.indices.componentType == 5122 || primitive.indices.componentType == 5126)) {
+                cout << "ERROR::MESH_LOADER: Invalid indices accessor in " << path << endl;
+                return false;
+            }
+            primitive.vertexBase = sourceCount;
+            primitive.indexBase = indexCount;
+            sourceCount += primitive.position.count;
+            indexCount += (primitive.hasIndices ? primitive.indices.count : primitive.position.count) / 3 * 3;
+            primitives.push_back(primitive);
+        }
+    }
+    if (indexCount == 0) {
+        cout << "ERROR::MESH_LOADER: No triangles in " << path << endl;
+        return false;
+    }
+
+    // 1. 源顶点按区间分块, 各块读取属性并在块内合并, remap 记录每个源顶点的块内序号
+    chunkCount = max(1, min(chunkCount, (int)(sourceCount / LOADER_MIN_VERTICES_PER_THREAD) + 1));
+    vector<GltfChunk> chunks(chunkCount);
+    vector<uint32_t> remap(sourceCount);
+    WorkerPool::shared().run(chunkCount, [&](int c){
+        GltfChunk &chunk = chunks[c];
+        chunk.first = sourceCount * c / chunkCount;
+        chunk.last = sourceCount * (c + 1) / chunkCount;
+        FlatHashMap<unsigned int> seen;
+        size_t p = 0;
+        while (p + 1 < primitives.size() && primitives[p + 1].vertexBase <= chunk.first)
+            p++;
+        for (size_t source = chunk.first; source < chunk.last; source++) {
+            while (source >= primitives[p].vertexBase + primitives[p].position.count)
+                p++;
+            const GltfPrimitive &primitive = primitives[p];
+            size_t i = source - primitive.vertexBase;
+            GltfVertex vertex;
+            gltfRead(primitive.position, i, vertex.position, 3);
+            if (primitive.hasNormal)
+                gltfRead(primitive.normal, i, vertex.normal, 3);
+            else
+                vertex.normal[0] = vertex.normal[1] = vertex.normal[2] = NAN;
+            if (primitive.hasTexCoord) {
+                gltfRead(primitive.texCoord, i, vertex.texCoord, 2);
+                // glTF 纹理坐标原点在左上角
+                vertex.texCoord[1] = 1.0f - vertex.texCoord[1];
+            }else{
+                vertex.texCoord[0] = vertex.texCoord[1] = NAN;
+            }
+            remap[source] = dedupVertex(seen, chunk.unique, vertex);
+        }
+    });
+    vertexCount = 0;
+    for (int c = 0; c < chunkCount; c++) {
+        chunks[c].vertexBase = vertexCount;
+        vertexCount += chunks[c].unique.size();
+    }
+
+    // 2. 收集合并后顶点的位置, remap 改成全局序号
+    positions.resize(vertexCount * 3);
+    WorkerPool::shared().run(chunkCount, [&](int c){
+        GltfChunk &chunk = chunks[c];
+        for (size_t i = 0; i < chunk.unique.size(); i++)
+            memcpy(&positions[(chunk.vertexBase + i) * 3], chunk.unique[i].position, sizeof(chunk.unique[i].position));
+        for (size_t source = chunk.first; source < chunk.last; source++)
+            remap[source] += (uint32_t)chunk.vertexBase;
+    });
+
+    // 3. 索引按图元转换
+    indexData = new unsigned char[indexCount * sizeof(GLuint)];
+    GLuint *indices = (GLuint *)indexData;
+    bool valid = true;
+    for (size_t p = 0; p < primitives.size(); p++) {
+        const GltfPrimitive &primitive = primitives[p];
+        size_t count = (primitive.hasIndices ? primitive.indices.count : primitive.position.count) / 3 * 3;
+        for (size_t i = 0; i < count; i++) {
+            unsigned int source = primitive.hasIndices ? gltfIndex(primitive.indices, i) : (unsigned int)i;
+            if (source >= primitive.position.count) {
+                valid = false;
+                source = 0;
+            }
+            indices[primitive.indexBase + i] = remap[primitive.vertexBase + source];
+        }
+    }
+    if (!valid) {
+        cout << "ERROR::MESH_LOADER: Index out of range in " << path << endl;
+        return false;
+    }
+
+    // 4. 重排三角形和顶点(没有被索引引用的顶点丢掉), 各块再把合并后的顶点压缩写到重排后的位置
+    vector<unsigned int> targets;
+    if (!optimize(targets))
+        return false;
+    vertexData = new unsigned char[vertexCount * format.stride];
+    WorkerPool::shared().run(chunkCount, [&](int c){
+        GltfChunk &chunk = chunks[c];
+        resetBounds(chunk.bounds);
+        for (size_t i = 0; i < chunk.unique.size(); i++) {
+            unsigned int target = targets[chunk.vertexBase + i];
+            if (target == MESH_UNUSED_VERTEX)
+                continue;
+            const GltfVertex &vertex = chunk.unique[i];
+            packVertex(format, vertex.position, isnan(vertex.normal[0]) ? NULL : vertex.normal, isnan(vertex.texCoord[0]) ? NULL : vertex.texCoord,
+                       vertexData + (size_t)target * format.stride);
+            growBounds(chunk.bounds, vertex.position);
+        }
+    });
+    mergeBounds(bounds, chunks);
+    return true;
+}
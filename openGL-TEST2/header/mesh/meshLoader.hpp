@@ -0,0 +1,92 @@
+//
+//  meshLoader.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/4/1.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef MESH_LOADER_H
+#define MESH_LOADER_H
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "vertexFormat.hpp"
+#include "geometryPool.hpp"
+#include "meshlet.hpp"
+
+// 模型加载的阶段
+enum MeshLoadState{
+    MESH_LOAD_IDLE,
+    MESH_LOAD_PARSING,      // 后台线程解析中
+    MESH_LOAD_UPLOADING,    // 解析完成, 每帧上传一部分
+    MESH_LOAD_READY,
+    MESH_LOAD_FAILED
+};
+
+// 流式模型加载: 支持 Wavefront OBJ 和 glTF 2.0 二进制(.glb, 只读 meshes 中的三角形图元, 不处理节点变换).
+// 1. start() 在主线程 mmap 文件(挂载了资源包时直接用包内的数据), 之后交给后台线程;
+// 2. 后台线程把文件切成若干块并行解析, 每块内用哈希合并相同的顶点,
+//    再按 optimizeMesh 的三步重排三角形和顶点, 最后写成 GeometryPool 的压缩格式(顶点 + 按池的索引类型存放的索引);
+// 3. 主线程每帧调用 update(), 解析完成后每帧最多上传 uploadBudget 字节, 不会长时间阻塞帧循环.
+// 后台线程在压缩前顺便切分 meshlet, 供 GeometryPool::drawCulled 剔除.
+class MeshLoader{
+public:
+    MeshLoader();
+    ~MeshLoader();
+
+    // 开始加载, 输出格式取 pool 的格式(需要在主线程调用); threads 为0时使用全部硬件线程
+    bool start(const char *path, const GeometryPool &pool, int threads = 0);
+    // 每帧调用一次, 加载完成(range() 可以绘制)时返回 true
+    bool update(GeometryPool &pool, size_t uploadBudget = 4 * 1024 * 1024);
+    // 等待后台线程并释放映射和暂存数据(池中已上传的数据不受影响)
+    void release();
+
+    MeshLoadState state() const { return (MeshLoadState)status.load(); }
+    const GeometryRange &range() const { return geometry; }
+    // 模型的包围盒(解析完成后有效), 用于把模型缩放到场景里
+    const float *boundsMin() const { return bounds; }
+    const float *boundsMax() const { return bounds + 3; }
+    const std::vector<Meshlet> &meshlets() const { return clusters; }
+
+private:
+    std::thread worker;
+    std::atomic<int> status;
+    std::string path;
+    int threads;
+
+    // 输入: 映射的文件(或资源包中的区间)
+    const unsigned char *data;
+    size_t length;
+    void *mapped;
+    size_t mappedLength;
+
+    // 输出: 压缩后的顶点和索引, 按池的格式存放
+    VertexFormat format;
+    GLenum indexType;
+    unsigned char *vertexData;
+    unsigned char *indexData;
+    size_t vertexCount, indexCount;
+    size_t verticesUploaded, indicesUploaded;
+    // 解析期间: 合并后顶点的 float 位置(3 个一组), 供优化三角形顺序和切分 meshlet 用
+    std::vector<float> positions;
+    float bounds[6];
+    GeometryRange geometry;
+    std::vector<Meshlet> clusters;
+
+    void parse();
+    bool parseObj(int chunkCount);
+    bool parseGlb(int chunkCount);
+    bool checkVertexCount(size_t count) const;
+    bool optimize(std::vector<unsigned int> &targets);
+
+    MeshLoader(const MeshLoader &);
+    MeshLoader &operator=(const MeshLoader &);
+};
+
+#endif /* meshLoader_hpp */
@@ -0,0 +1,371 @@
+//
+//  meshOptimizer.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/30.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "meshOptimizer.hpp"
+#include "../util/flatHashMap.hpp"
+#include "../util/hash.hpp"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace std;
+
+VertexCacheStats analyzeVertexCache(const unsigned int *indices, size_t indexCount, size_t vertexCount, int cacheSize){
+    VertexCacheStats stats = {0.0f, 0.0f};
+    if (indexCount < 3 || vertexCount == 0)
+        return stats;
+    // 时间戳记录顶点进入缓存时的未命中计数, 之后又发生 cacheSize 次未命中就被挤出
+    vector<size_t> stamps(vertexCount, 0);
+    size_t misses = 0, clock = (size_t)cacheSize + 1;
+    for (size_t i = 0; i < indexCount; i++) {
+        unsigned int v = indices[i];
+        if (clock - stamps[v] > (size_t)cacheSize) {
+            stamps[v] = clock++;
+            misses++;
+        }
+    }
+    stats.acmr = (float)misses / (indexCount / 3);
+    stats.atvr = (float)misses / vertexCount;
+    return stats;
+}
+
+size_t generateIndices(const float *vertices, size_t vertexCount, int stride, float *unique, unsigned int *indices){
+    // 哈希 -> 顶点, 按字节比较(-0 和 0 视为不同, 不影响正确性); 哈希相同但内容不同时顺延到下一个键
+    FlatHashMap<unsigned int> seen;
+    size_t uniqueCount = 0;
+    for (size_t i = 0; i < vertexCount; i++) {
+        const float *vertex = vertices + i * stride;
+        uint64_t key = fnv1a64(vertex, stride * sizeof(float));
+        for (;; key++) {
+            unsigned int *found = seen.find(key);
+            if (found == NULL) {
+                memcpy(unique + uniqueCount * stride, vertex, stride * sizeof(float));
+                seen.insert(key, (unsigned int)uniqueCount);
+                indices[i] = (unsigned int)uniqueCount++;
+                break;
+            }
+            if (memcmp(unique + (size_t)*found * stride, vertex, stride * sizeof(float)) == 0) {
+                indices[i] = *found;
+                break;
+            }
+        }
+    }
+    return uniqueCount;
+}
+
+// ===== Forsyth, Linear-Speed Vertex Cache Optimisation =====
+const int FORSYTH_CACHE_SIZE = 32;
+const int FORSYTH_MAX_VALENCE = 32;
+
+// 得分表在第一次使用时构造; 函数内的静态对象由编译器保证只初始化一次, 多个线程同时优化网格也是安全的
+struct ForsythScores{
+    float cache[FORSYTH_CACHE_SIZE];
+    float valence[FORSYTH_MAX_VALENCE + 1];
+
+    ForsythScores(){
+        for (int i = 0; i < FORSYTH_CACHE_SIZE; i++) {
+            // 最近一个三角形的三个顶点得分固定, 避免总是沿同一条带走下去
+            if (i < 3)
+                cache[i] = 0.75f;
+            else
+                cache[i] = powf(1.0f - (float)(i - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+        }
+        // 剩下的三角形越少越优先, 尽快用完一个顶点
+        valence[0] = 0.0f;
+        for (int i = 1; i <= FORSYTH_MAX_VALENCE; i++)
+            valence[i] = 2.0f / sqrtf((float)i);
+    }
+};
+
+static const ForsythScores &forsythScores(){
+    static const ForsythScores scores;
+    return scores;
+}
+
+static float vertexScore(const ForsythScores &scores, int cachePosition, unsigned int remaining){
+    if (remaining == 0)
+        return -1.0f;
+    float score = cachePosition >= 0 ? scores.cache[cachePosition] : 0.0f;
+    return score + scores.valence[min(remaining, (unsigned int)FORSYTH_MAX_VALENCE)];
+}
+
+void optimizeVertexCache(unsigned int *indices, size_t indexCount, size_t vertexCount){
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+    const ForsythScores &scores = forsythScores();
+
+    // 每个顶点相邻的三角形, 已输出的三角形从列表尾部换出
+    vector<unsigned int> remaining(vertexCount, 0);
+    vector<size_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        remaining[indices[i]]++;
+    for (size_t v = 0; v < vertexCount; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    vector<unsigned int> adjacency(triangleCount * 3);
+    vector<size_t> filled(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        adjacency[filled[indices[i]]++] = (unsigned int)(i / 3);
+
+    vector<int> cachePositions(vertexCount, -1);
+    vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScores[v] = vertexScore(scores, -1, remaining[v]);
+    vector<float> triangleScores(triangleCount);
+    vector<bool> emitted(triangleCount, false);
+    size_t best = 0;
+    for (size_t t = 0; t < triangleCount; t++) {
+        const unsigned int *tri = indices + t * 3;
+        triangleScores[t] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+        if (triangleScores[t] > triangleScores[best])
+            best = t;
+    }
+
+    vector<unsigned int> output(triangleCount * 3);
+    vector<unsigned int> cache, nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+    size_t cursor = 0;
+    for (size_t n = 0; n < triangleCount; n++) {
+        // 缓存里的顶点都没有剩余三角形时, 从头找下一个没有输出的三角形
+        if (best == (size_t)-1) {
+            while (emitted[cursor])
+                cursor++;
+            best = cursor;
+        }
+        const unsigned int *tri = indices + best * 3;
+        memcpy(&output[n * 3], tri, 3 * sizeof(unsigned int));
+        emitted[best] = true;
+
+        nextCache.assign(tri, tri + 3);
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = tri[k];
+            unsigned int *list = &adjacency[offsets[v]];
+            for (unsigned int j = 0; j < remaining[v]; j++) {
+                if (list[j] == best) {
+                    list[j] = list[remaining[v] - 1];
+                    break;
+                }
+            }
+            remaining[v]--;
+        }
+        for (size_t i = 0; i < cache.size(); i++)
+            if (cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2])
+                nextCache.push_back(cache[i]);
+
+        // 更新缓存位置和得分, 挤出缓存的顶点也要更新
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            unsigned int v = nextCache[i];
+            cachePositions[v] = i < (size_t)FORSYTH_CACHE_SIZE ? (int)i : -1;
+            float score = vertexScore(scores, cachePositions[v], remaining[v]);
+            float delta = score - vertexScores[v];
+            vertexScores[v] = score;
+            const unsigned int *list = &adjacency[offsets[v]];
+            for (unsigned int j = 0; j < remaining[v]; j++)
+                triangleScores[list[j]] += delta;
+        }
+        if (nextCache.size() > (size_t)FORSYTH_CACHE_SIZE)
+            nextCache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(nextCache);
+
+        // 下一个三角形只在缓存中顶点的相邻三角形里找
+        best = (size_t)-1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < cache.size(); i++) {
+            unsigned int v = cache[i];
+            const unsigned int *list = &adjacency[offsets[v]];
+            for (unsigned int j = 0; j < remaining[v]; j++) {
+                if (triangleScores[list[j]] > bestScore) {
+                    bestScore = triangleScores[list[j]];
+                    best = list[j];
+                }
+            }
+        }
+    }
+    memcpy(indices, &output[0], output.size() * sizeof(unsigned int));
+}
+
+// ===== Sander, Nehab, Barczak, Fast Triangle Reordering for Vertex Locality and Reduced Overdraw =====
+struct Cluster{
+    size_t first;
+    size_t count;
+    float sortKey;
+};
+
+static bool clusterOutward(const Cluster &a, const Cluster &b){
+    return a.sortKey > b.sortKey;
+}
+
+void optimizeOverdraw(unsigned int *indices, size_t indexCount, const float *vertices, size_t vertexCount, int stride, int cacheSize){
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return;
+
+    // 三个顶点都未命中的三角形处缓存已经冷了, 在这里切开的簇随便换顺序都不影响 ACMR
+    vector<Cluster> clusters;
+    vector<size_t> stamps(vertexCount, 0);
+    size_t clock = (size_t)cacheSize + 1;
+    for (size_t t = 0; t < triangleCount; t++) {
+        int misses = 0;
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = indices[t * 3 + k];
+            if (clock - stamps[v] > (size_t)cacheSize) {
+                stamps[v] = clock++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3) {
+            Cluster cluster = {t, 0, 0.0f};
+            clusters.push_back(cluster);
+        }
+        clusters.back().count++;
+    }
+    if (clusters.size() < 2)
+        return;
+
+    // 网格中心
+    double center[3] = {0.0, 0.0, 0.0};
+    for (size_t v = 0; v < vertexCount; v++)
+        for (int k = 0; k < 3; k++)
+            center[k] += vertices[v * stride + k];
+    for (int k = 0; k < 3; k++)
+        center[k] /= vertexCount;
+
+    // 簇的面积加权中心与法线, 中心沿法线离网格中心越远越靠外, 越先画
+    for (size_t c = 0; c < clusters.size(); c++) {
+        Cluster &cluster = clusters[c];
+        float centroid[3] = {0.0f, 0.0f, 0.0f}, normal[3] = {0.0f, 0.0f, 0.0f};
+        float area = 0.0f;
+        for (size_t t = cluster.first; t < cluster.first + cluster.count; t++) {
+            const float *a = vertices + indices[t * 3] * stride;
+            const float *b = vertices + indices[t * 3 + 1] * stride;
+            const float *d = vertices + indices[t * 3 + 2] * stride;
+            float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            float ad[3] = {d[0] - a[0], d[1] - a[1], d[2] - a[2]};
+            float n[3] = {ab[1] * ad[2] - ab[2] * ad[1], ab[2] * ad[0] - ab[0] * ad[2], ab[0] * ad[1] - ab[1] * ad[0]};
+            float weight = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; k++) {
+                centroid[k] += (a[k] + b[k] + d[k]) * weight / 3.0f;
+                normal[k] += n[k];
+            }
+            area += weight;
+        }
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (area <= 0.0f || length <= 0.0f)
+            continue;
+        float key = 0.0f;
+        for (int k = 0; k < 3; k++)
+            key += (centroid[k] / area - (float)center[k]) * normal[k] / length;
+        cluster.sortKey = key;
+    }
+    stable_sort(clusters.begin(), clusters.end(), clusterOutward);
+
+    vector<unsigned int> output;
+    output.reserve(triangleCount * 3);
+    for (size_t c = 0; c < clusters.size(); c++)
+        output.insert(output.end(), indices + clusters[c].first * 3, indices + (clusters[c].first + clusters[c].count) * 3);
+    memcpy(indices, &output[0], output.size() * sizeof(unsigned int));
+}
+
+size_t optimizeVertexFetchRemap(unsigned int *remap, unsigned int *indices, size_t indexCount, size_t vertexCount){
+    for (size_t v = 0; v < vertexCount; v++)
+        remap[v] = MESH_UNUSED_VERTEX;
+    unsigned int next = 0;
+    for (size_t i = 0; i < indexCount; i++) {
+        unsigned int &target = remap[indices[i]];
+        if (target == MESH_UNUSED_VERTEX)
+            target = next++;
+        indices[i] = target;
+    }
+    return next;
+}
+
+size_t optimizeVertexFetch(float *vertices, size_t vertexCount, int stride, unsigned int *indices, size_t indexCount){
+    vector<unsigned int> remap(vertexCount);
+    size_t count = optimizeVertexFetchRemap(remap.empty() ? NULL : &remap[0], indices, indexCount, vertexCount);
+    vector<float> reordered(count * stride);
+    for (size_t v = 0; v < vertexCount; v++)
+        if (remap[v] != MESH_UNUSED_VERTEX)
+            memcpy(&reordered[(size_t)remap[v] * stride], vertices + v * stride, stride * sizeof(float));
+    if (count > 0)
+        memcpy(vertices, &reordered[0], reordered.size() * sizeof(float));
+    return count;
+}
+
+size_t optimizeMesh(float *vertices, size_t vertexCount, int stride, unsigned int *indices, size_t indexCount){
+    optimizeVertexCache(indices, indexCount, vertexCount);
+    optimizeOverdraw(indices, indexCount, vertices, vertexCount, stride);
+    return optimizeVertexFetch(vertices, vertexCount, stride, indices, indexCount);
+}
+
+static uint64_t edgeKey(unsigned int from, unsigned int to){
+    return (uint64_t)from << 32 | to;
+}
+
+void stripify(const unsigned int *indices, size_t indexCount, vector<unsigned int> &strips){
+    strips.clear();
+    size_t triangleCount = indexCount / 3;
+    // 有向边 -> 所在三角形; 朝向一致时相邻三角形在共享边上方向相反
+    FlatHashMap<unsigned int> edges;
+    for (size_t t = 0; t < triangleCount; t++)
+        for (int k = 0; k < 3; k++)
+            edges.insert(edgeKey(indices[t * 3 + k], indices[t * 3 + (k + 1) % 3]), (unsigned int)t);
+
+    vector<bool> used(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; t++) {
+        if (used[t])
+            continue;
+        const unsigned int *tri = indices + t * 3;
+        // 带中第 i 个三角形由 s[i], s[i+1], s[i+2] 组成, 奇数个时GL反转前两个顶点,
+        // 所以第二个三角形要包含有向边 (s[2], s[1]); 选一个能接上第二个三角形的起始顶点
+        int rotation = 0;
+        for (int r = 0; r < 3; r++) {
+            unsigned int *next = edges.find(edgeKey(tri[(r + 2) % 3], tri[(r + 1) % 3]));
+            if (next != NULL && !used[*next]) {
+                rotation = r;
+                break;
+            }
+        }
+        if (!strips.empty())
+            strips.push_back(MESH_RESTART_INDEX);
+        for (int k = 0; k < 3; k++)
+            strips.push_back(tri[(rotation + k) % 3]);
+        used[t] = true;
+
+        for (size_t i = 1;; i++) {
+            unsigned int a = strips[strips.size() - 2], b = strips[strips.size() - 1];
+            unsigned int from = (i & 1) ? b : a, to = (i & 1) ? a : b;
+            unsigned int *next = edges.find(edgeKey(from, to));
+            if (next == NULL || used[*next])
+                break;
+            const unsigned int *other = indices + (size_t)*next * 3;
+            int k = 0;
+            while (k < 3 && !(other[k] == from && other[(k + 1) % 3] == to))
+                k++;
+            strips.push_back(other[(k + 2) % 3]);
+            used[*next] = true;
+        }
+    }
+}
+
+void unstripify(const unsigned int *strips, size_t stripCount, vector<unsigned int> &indices){
+    indices.clear();
+    size_t start = 0;
+    for (size_t i = 0; i <= stripCount; i++) {
+        if (i < stripCount && strips[i] != MESH_RESTART_INDEX)
+            continue;
+        for (size_t k = start; k + 2 < i; k++) {
+            bool odd = ((k - start) & 1) != 0;
+            indices.push_back(strips[odd ? k + 1 : k]);
+            indices.push_back(strips[odd ? k : k + 1]);
+            indices.push_back(strips[k + 2]);
+        }
+        start = i + 1;
+    }
+}
@@ -0,0 +1,56 @@
+//
+//  meshOptimizer.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/30.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <iostream>
+#include <vector>
+
+// 索引网格的离线优化, 按顺序调用:
+// 1. optimizeVertexCache: 重排三角形, 提高变换后顶点缓存命中率(Forsyth 算法)
+// 2. optimizeOverdraw:    在缓存完全失效的位置把三角形分簇, 朝外的簇先画, 减少遮挡前的重复着色
+// 3. optimizeVertexFetch: 按第一次使用的顺序重排顶点, 让顶点读取顺序访问内存
+// 之后可选 stripify 转成带图元重启的三角形带.
+// 顶点为 stride 个 float 一个, 位置在开头.
+
+// stripify 输出中的图元重启标记, 转成 16 位索引时换成 0xFFFF
+#define MESH_RESTART_INDEX 0xFFFFFFFFu
+// optimizeVertexFetchRemap 中没有被引用的顶点
+#define MESH_UNUSED_VERTEX 0xFFFFFFFFu
+
+// ACMR: 每个三角形的平均缓存未命中数(顶点着色次数 / 三角形数), 理想值约 0.5
+// ATVR: 顶点着色次数 / 顶点数, 理想值 1.0
+struct VertexCacheStats{
+    float acmr;
+    float atvr;
+};
+
+// 用 cacheSize 大小的 FIFO 缓存模拟 GPU 的变换后缓存
+VertexCacheStats analyzeVertexCache(const unsigned int *indices, size_t indexCount, size_t vertexCount, int cacheSize = 16);
+
+// 没有索引的三角形列表(如立方体的 36 个顶点)合并相同的顶点: unique 至少能放 vertexCount 个顶点,
+// indices 为 vertexCount 个, 返回合并后的顶点数
+size_t generateIndices(const float *vertices, size_t vertexCount, int stride, float *unique, unsigned int *indices);
+
+void optimizeVertexCache(unsigned int *indices, size_t indexCount, size_t vertexCount);
+// 簇边界按 cacheSize 大小的 FIFO 缓存模拟判断
+void optimizeOverdraw(unsigned int *indices, size_t indexCount, const float *vertices, size_t vertexCount, int stride, int cacheSize = 16);
+// 原地重排顶点并改写索引, 没有被引用的顶点被丢弃, 返回剩下的顶点数
+size_t optimizeVertexFetch(float *vertices, size_t vertexCount, int stride, unsigned int *indices, size_t indexCount);
+// 只改写索引, remap[旧序号] 为新序号(未引用的为 MESH_UNUSED_VERTEX), 顶点不是 float 数组时由调用者自己搬
+size_t optimizeVertexFetchRemap(unsigned int *remap, unsigned int *indices, size_t indexCount, size_t vertexCount);
+// 依次执行上面三步, 返回剩下的顶点数
+size_t optimizeMesh(float *vertices, size_t vertexCount, int stride, unsigned int *indices, size_t indexCount);
+// 三角形列表转为三角形带(GL_TRIANGLE_STRIP), 带之间用 MESH_RESTART_INDEX 分隔, 朝向与原三角形一致.
+// 贪心地沿共享边延伸, 对球体这样的规则网格基本是一行一条带.
+void stripify(const unsigned int *indices, size_t indexCount, std::vector<unsigned int> &strips);
+// 三角形带还原为三角形列表(用于统计 ACMR 等)
+void unstripify(const unsigned int *strips, size_t stripCount, std::vector<unsigned int> &indices);
+
+#endif /* meshOptimizer_hpp */
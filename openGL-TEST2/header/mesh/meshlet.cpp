@@ -0,0 +1,191 @@
+//
+//  meshlet.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/4/2.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "meshlet.hpp"
+
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+
+using namespace std;
+
+static void finishMeshlet(Meshlet &meshlet, const unsigned int *indices, const float *vertices, int stride, const vector<unsigned int> &used){
+    // 包围球: 包围盒中心, 半径取最远的顶点
+    float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX}, hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (size_t i = 0; i < used.size(); i++) {
+        const float *p = vertices + (size_t)used[i] * stride;
+        for (int k = 0; k < 3; k++) {
+            lo[k] = fminf(lo[k], p[k]);
+            hi[k] = fmaxf(hi[k], p[k]);
+        }
+    }
+    float radius2 = 0.0f;
+    for (int k = 0; k < 3; k++)
+        meshlet.center[k] = (lo[k] + hi[k]) * 0.5f;
+    for (size_t i = 0; i < used.size(); i++) {
+        const float *p = vertices + (size_t)used[i] * stride;
+        float dx = p[0] - meshlet.center[0], dy = p[1] - meshlet.center[1], dz = p[2] - meshlet.center[2];
+        radius2 = fmaxf(radius2, dx * dx + dy * dy + dz * dz);
+    }
+    meshlet.radius = sqrtf(radius2);
+
+    // 法线锥: 轴为各三角形单位法线之和的方向, 半角由与轴夹角最大的法线决定
+    vector<float> normals(meshlet.indexCount);
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    for (unsigned int i = 0; i < meshlet.indexCount; i += 3) {
+        const unsigned int *triangle = indices + meshlet.firstIndex + i;
+        const float *a = vertices + (size_t)triangle[0] * stride, *b = vertices + (size_t)triangle[1] * stride, *c = vertices + (size_t)triangle[2] * stride;
+        float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        float *n = &normals[i];
+        n[0] = ab[1] * ac[2] - ab[2] * ac[1];
+        n[1] = ab[2] * ac[0] - ab[0] * ac[2];
+        n[2] = ab[0] * ac[1] - ab[1] * ac[0];
+        float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        // 退化三角形没有朝向, 不参与
+        float scale = length > 0.0f ? 1.0f / length : 0.0f;
+        for (int k = 0; k < 3; k++) {
+            n[k] *= scale;
+            axis[k] += n[k];
+        }
+    }
+    float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    float minDot = 1.0f;
+    if (length > 0.0f) {
+        for (int k = 0; k < 3; k++)
+            axis[k] /= length;
+        for (unsigned int i = 0; i < meshlet.indexCount; i += 3) {
+            const float *n = &normals[i];
+            if (n[0] != 0.0f || n[1] != 0.0f || n[2] != 0.0f)
+                minDot = fminf(minDot, n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]);
+        }
+    }else{
+        minDot = 0.0f;
+    }
+    for (int k = 0; k < 3; k++)
+        meshlet.coneAxis[k] = axis[k];
+    meshlet.coneCutoff = minDot > 0.0f ? sqrtf(1.0f - minDot * minDot) : 1.0f;
+}
+
+void buildMeshlets(const unsigned int *indices, size_t indexCount, const float *vertices, size_t vertexCount, int stride, vector<Meshlet> &meshlets){
+    meshlets.clear();
+    if (indexCount < 3)
+        return;
+    // stamp 记录顶点最后加入的簇, 不用每个簇清一次表
+    vector<unsigned int> stamp(vertexCount, UINT_MAX);
+    vector<unsigned int> used;
+    used.reserve(MESHLET_MAX_VERTICES);
+    Meshlet current = {0, 0, 0, {0.0f, 0.0f, 0.0f}, 0.0f, {0.0f, 0.0f, 0.0f}, 1.0f};
+    unsigned int id = 0;
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        unsigned int added = (stamp[a] != id) + (stamp[b] != id && b != a) + (stamp[c] != id && c != a && c != b);
+        if (current.vertexCount + added > MESHLET_MAX_VERTICES || current.indexCount / 3 + 1 > MESHLET_MAX_TRIANGLES) {
+            finishMeshlet(current, indices, vertices, stride, used);
+            meshlets.push_back(current);
+            current.firstIndex = (unsigned int)i;
+            current.indexCount = current.vertexCount = 0;
+            used.clear();
+            id++;
+            added = 1 + (b != a) + (c != a && c != b);
+        }
+        const unsigned int triangle[3] = {a, b, c};
+        for (int k = 0; k < 3; k++) {
+            if (stamp[triangle[k]] != id) {
+                stamp[triangle[k]] = id;
+                used.push_back(triangle[k]);
+            }
+        }
+        current.vertexCount += added;
+        current.indexCount += 3;
+    }
+    finishMeshlet(current, indices, vertices, stride, used);
+    meshlets.push_back(current);
+}
+
+void MeshletCuller::setup(const glm::mat4 &modelViewProjection){
+    // glm 按列存放, row[i] 为矩阵的第 i 行
+    float row[4][4];
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            row[i][j] = modelViewProjection[j][i];
+
+    // Gribb-Hartmann: 左右下上近远 = 第4行 ± 第1/2/3行
+    for (int p = 0; p < 6; p++) {
+        float sign = p % 2 == 0 ? 1.0f : -1.0f;
+        for (int k = 0; k < 4; k++)
+            planes[p][k] = row[3][k] + sign * row[p / 2][k];
+        float length = sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        if (length > 0.0f)
+            for (int k = 0; k < 4; k++)
+                planes[p][k] /= length;
+    }
+
+    // 正交投影的 w 与位置无关; 透视投影的视点满足 x = y = w = 0
+    orthographic = fabsf(row[3][0]) + fabsf(row[3][1]) + fabsf(row[3][2]) < 1e-6f;
+    const float *r0 = row[0], *r1 = row[1], *r3 = row[3];
+    if (orthographic) {
+        // 视线方向与第1、2行的 xyz 都垂直, 朝深度增加的一侧
+        float d[3] = {r0[1] * r1[2] - r0[2] * r1[1], r0[2] * r1[0] - r0[0] * r1[2], r0[0] * r1[1] - r0[1] * r1[0]};
+        float length = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        if (d[0] * row[2][0] + d[1] * row[2][1] + d[2] * row[2][2] < 0.0f)
+            length = -length;
+        for (int k = 0; k < 3; k++) {
+            direction[k] = length != 0.0f ? d[k] / length : 0.0f;
+            eye[k] = 0.0f;
+        }
+        return;
+    }
+    // 克莱姆法则解 3x3 方程组
+    float det = r0[0] * (r1[1] * r3[2] - r1[2] * r3[1]) - r0[1] * (r1[0] * r3[2] - r1[2] * r3[0]) + r0[2] * (r1[0] * r3[1] - r1[1] * r3[0]);
+    float b[3] = {-r0[3], -r1[3], -r3[3]};
+    for (int k = 0; k < 3; k++) {
+        float m[3][3];
+        const float *rows[3] = {r0, r1, r3};
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                m[i][j] = j == k ? b[i] : rows[i][j];
+        float minor = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        eye[k] = det != 0.0f ? minor / det : 0.0f;
+        direction[k] = 0.0f;
+    }
+}
+
+bool MeshletCuller::visible(const Meshlet &meshlet) const{
+    const float *c = meshlet.center;
+    for (int p = 0; p < 6; p++)
+        if (planes[p][0] * c[0] + planes[p][1] * c[1] + planes[p][2] * c[2] + planes[p][3] < -meshlet.radius)
+            return false;
+    if (meshlet.coneCutoff >= 1.0f)
+        return true;
+    const float *axis = meshlet.coneAxis;
+    // 所有三角形都背对视点: 视线与锥轴的夹角小于 90° - 半角; 透视时用包围球保守地估计簇内各点的视线
+    if (orthographic)
+        return direction[0] * axis[0] + direction[1] * axis[1] + direction[2] * axis[2] < meshlet.coneCutoff;
+    float v[3] = {c[0] - eye[0], c[1] - eye[1], c[2] - eye[2]};
+    float distance = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    return v[0] * axis[0] + v[1] * axis[1] + v[2] * axis[2] < meshlet.coneCutoff * distance + meshlet.radius;
+}
+
+size_t cullMeshlets(const vector<Meshlet> &meshlets, const GeometryRange &range, const MeshletCuller &culler, vector<GeometryRange> &ranges){
+    size_t begin = ranges.size(), count = 0;
+    for (size_t i = 0; i < meshlets.size(); i++) {
+        const Meshlet &meshlet = meshlets[i];
+        if (!culler.visible(meshlet))
+            continue;
+        count++;
+        size_t first = range.firstIndex + meshlet.firstIndex;
+        if (ranges.size() > begin && ranges.back().firstIndex + ranges.back().indexCount == first) {
+            ranges.back().indexCount += meshlet.indexCount;
+            continue;
+        }
+        GeometryRange visible = {GL_TRIANGLES, range.baseVertex, first, (GLsizei)meshlet.indexCount, range.vertexCount};
+        ranges.push_back(visible);
+    }
+    return count;
+}
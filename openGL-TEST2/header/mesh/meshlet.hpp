@@ -0,0 +1,54 @@
+//
+//  meshlet.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/4/2.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <iostream>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "geometryPool.hpp"
+
+// 把索引网格切成小簇(meshlet), 每个 pass 在提交之前按簇剔除:
+// 包围球在视锥外, 或法线锥整体背对视点(相机, 或阴影 pass 的光源)的簇不画.
+// 一个簇的三角形在索引缓冲中是连续的, 剩下的簇合并成若干段用 glMultiDrawElementsBaseVertex 一次提交.
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+struct Meshlet{
+    unsigned int firstIndex;    // 相对网格的第一个索引
+    unsigned int indexCount;
+    unsigned int vertexCount;   // 用到的不同顶点数
+    float center[3];            // 包围球
+    float radius;
+    float coneAxis[3];          // 法线锥: 所有三角形的法线与 coneAxis 的夹角都不超过半角
+    float coneCutoff;           // sin(半角); 锥超过半球时为 1, 不做背面剔除
+};
+
+// 按索引顺序贪心地切分三角形列表, 满 64 个顶点或 124 个三角形时开始下一个簇.
+// 索引先做过 optimizeVertexCache 时相邻三角形在空间上也相邻, 簇比较紧凑.
+// 顶点为 stride 个 float 一个, 位置在开头; 法线锥用三角形的几何法线(逆时针为正面)
+void buildMeshlets(const unsigned int *indices, size_t indexCount, const float *vertices, size_t vertexCount, int stride, std::vector<Meshlet> &meshlets);
+
+// 一个 pass 中一个物体的剔除参数, 全部从 projection * view * model 推出, 在模型空间中计算,
+// 所以簇的包围球和法线锥不需要变换. 透视投影按视点剔除, 正交投影(方向光阴影)按视线方向剔除
+struct MeshletCuller{
+    float planes[6][4];     // 视锥平面, 法线指向内侧
+    float eye[3];
+    float direction[3];
+    bool orthographic;
+
+    void setup(const glm::mat4 &modelViewProjection);
+    bool visible(const Meshlet &meshlet) const;
+};
+
+// 剔除后把可见的簇追加到 ranges(range 为整个网格在池中的位置), 相邻的簇合并成一段; 返回可见的簇数
+size_t cullMeshlets(const std::vector<Meshlet> &meshlets, const GeometryRange &range, const MeshletCuller &culler, std::vector<GeometryRange> &ranges);
+
+#endif /* meshlet_hpp */
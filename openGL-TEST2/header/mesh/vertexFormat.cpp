@@ -0,0 +1,194 @@
+//
+//  vertexFormat.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/27.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "vertexFormat.hpp"
+#include "meshOptimizer.hpp"
+
+#include <math.h>
+#include <string.h>
+
+using namespace std;
+
+void VertexFormat::setup(size_t base) const{
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, positionType, GL_FALSE, stride, (void*)base);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)(base + normalOffset));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, texCoordType, texCoordType == GL_UNSIGNED_SHORT ? GL_TRUE : GL_FALSE, stride, (void*)(base + texCoordOffset));
+}
+
+static float signNotZero(float value){
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+static int16_t toSnorm16(float value){
+    if (value > 1.0f) value = 1.0f;
+    if (value < -1.0f) value = -1.0f;
+    return (int16_t)lroundf(value * 32767.0f);
+}
+
+static uint16_t toUnorm16(float value){
+    if (value > 1.0f) value = 1.0f;
+    if (value < 0.0f) value = 0.0f;
+    return (uint16_t)lroundf(value * 65535.0f);
+}
+
+void octEncode(float x, float y, float z, int16_t encoded[2]){
+    float length = fabsf(x) + fabsf(y) + fabsf(z);
+    if (length == 0.0f) {
+        encoded[0] = encoded[1] = 0;
+        return;
+    }
+    // 投影到八面体 |x|+|y|+|z|=1, 下半球沿对角线折到外侧
+    x /= length;
+    y /= length;
+    if (z < 0.0f) {
+        float ox = x;
+        x = (1.0f - fabsf(y)) * signNotZero(x);
+        y = (1.0f - fabsf(ox)) * signNotZero(y);
+    }
+    encoded[0] = toSnorm16(x);
+    encoded[1] = toSnorm16(y);
+}
+
+// 着色器中的版本在 shaders/octDecode.glsl, 修改时两边一起改
+void octDecode(const int16_t encoded[2], float normal[3]){
+    float x = encoded[0] / 32767.0f, y = encoded[1] / 32767.0f;
+    float z = 1.0f - fabsf(x) - fabsf(y);
+    float t = z < 0.0f ? -z : 0.0f;
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    float length = sqrtf(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+uint16_t floatToHalf(float value){
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff)            // Inf/NaN
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    if (exponent >= 31)                           // 溢出
+        return sign | 0x7c00;
+    if (exponent <= 0) {                          // 非规格化数或下溢为0
+        if (exponent < -10)
+            return sign;
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            half++;
+        return sign | (uint16_t)half;
+    }
+    // 就近舍入到偶数, 进位可能进到指数
+    uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half++;
+    return sign | (uint16_t)half;
+}
+
+float halfToFloat(uint16_t value){
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    float result;
+    if (exponent == 0) {
+        result = ldexpf((float)mantissa, -24);
+        if (sign)
+            result = -result;
+        return result;
+    }
+    uint32_t bits = exponent == 31 ? (sign | 0x7f800000 | (mantissa << 13)) : (sign | ((exponent - 15 + 127) << 23) | (mantissa << 13));
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void packVertices(const float *vertices, size_t vertexCount, int stride, int normalOffset, int texCoordOffset, bool halfPosition, PackedVertices &packed, GLenum texCoordType){
+    // 纹理坐标超出 [0,1](重复贴图)时 unorm16 放不下, 改用 half
+    bool unitTexCoords = texCoordType != GL_HALF_FLOAT;
+    if (texCoordOffset >= 0 && texCoordType == 0) {
+        for (size_t i = 0; i < vertexCount && unitTexCoords; i++) {
+            const float *uv = vertices + i * stride + texCoordOffset;
+            if (uv[0] < 0.0f || uv[0] > 1.0f || uv[1] < 0.0f || uv[1] > 1.0f)
+                unitTexCoords = false;
+        }
+    }
+
+    VertexFormat &format = packed.format;
+    format.positionType = halfPosition ? GL_HALF_FLOAT : GL_FLOAT;
+    format.texCoordType = unitTexCoords ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT;
+    format.normalOffset = halfPosition ? 4 * sizeof(uint16_t) : 3 * sizeof(float);
+    format.texCoordOffset = format.normalOffset + 2 * sizeof(int16_t);
+    format.stride = (GLsizei)(format.texCoordOffset + 2 * sizeof(uint16_t));
+    packed.vertexCount = vertexCount;
+    packed.data.assign(vertexCount * format.stride, 0);
+
+    for (size_t i = 0; i < vertexCount; i++) {
+        const float *src = vertices + i * stride;
+        packVertex(format, src, normalOffset >= 0 ? src + normalOffset : NULL, texCoordOffset >= 0 ? src + texCoordOffset : NULL, &packed.data[i * format.stride]);
+    }
+}
+
+void packVertex(const VertexFormat &format, const float *position, const float *normal, const float *texCoord, unsigned char *dst){
+    if (format.positionType == GL_HALF_FLOAT) {
+        uint16_t half[4] = {floatToHalf(position[0]), floatToHalf(position[1]), floatToHalf(position[2]), 0};
+        memcpy(dst, half, sizeof(half));
+    }else{
+        memcpy(dst, position, 3 * sizeof(float));
+    }
+    int16_t encoded[2] = {0, 0};
+    if (normal != NULL)
+        octEncode(normal[0], normal[1], normal[2], encoded);
+    memcpy(dst + format.normalOffset, encoded, sizeof(encoded));
+    uint16_t uv[2] = {0, 0};
+    if (texCoord != NULL) {
+        if (format.texCoordType == GL_UNSIGNED_SHORT) {
+            uv[0] = toUnorm16(texCoord[0]);
+            uv[1] = toUnorm16(texCoord[1]);
+        }else{
+            uv[0] = floatToHalf(texCoord[0]);
+            uv[1] = floatToHalf(texCoord[1]);
+        }
+    }
+    memcpy(dst + format.texCoordOffset, uv, sizeof(uv));
+}
+
+GLenum indexTypeFor(size_t vertexCount, bool primitiveRestart){
+    size_t limit = primitiveRestart ? 0xFFFF : 0x10000;
+    return vertexCount <= limit ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+size_t indexSize(GLenum indexType){
+    return indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+GLuint restartIndexFor(GLenum indexType){
+    return indexType == GL_UNSIGNED_SHORT ? 0xFFFF : 0xFFFFFFFF;
+}
+
+void appendIndices(const unsigned int *indices, size_t count, GLenum indexType, vector<unsigned char> &out){
+    size_t offset = out.size();
+    out.resize(offset + count * indexSize(indexType));
+    if (indexType != GL_UNSIGNED_SHORT) {
+        if (count > 0)
+            memcpy(&out[offset], indices, count * sizeof(GLuint));
+        return;
+    }
+    GLushort *dst = (GLushort *)&out[offset];
+    for (size_t i = 0; i < count; i++)
+        dst[i] = indices[i] == MESH_RESTART_INDEX ? (GLushort)0xFFFF : (GLushort)indices[i];
+}
@@ -0,0 +1,62 @@
+//
+//  vertexFormat.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/27.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+// 压缩后的交错顶点格式, 属性位置与原来的 8 float 布局一致:
+//   location 0: 位置, float x3(12字节) 或 half x3 + 填充(8字节)
+//   location 1: 法线, 八面体编码的 snorm16 x2(4字节), 着色器中用 octDecode 还原
+//   location 2: 纹理坐标, 全在 [0,1] 内时为 unorm16 x2, 否则(如地板的重复贴图)为 half x2(4字节)
+// 每个顶点 16 或 20 字节, 原来是 32 字节.
+struct VertexFormat{
+    GLenum positionType;    // GL_FLOAT 或 GL_HALF_FLOAT
+    GLenum texCoordType;    // GL_UNSIGNED_SHORT(归一化) 或 GL_HALF_FLOAT
+    GLsizei stride;
+    size_t normalOffset;
+    size_t texCoordOffset;
+
+    // 按格式设置当前绑定的VAO/VBO的属性 0, 1, 2; base 为顶点数据在VBO中的字节偏移
+    void setup(size_t base = 0) const;
+};
+
+// 压缩后的顶点数据
+struct PackedVertices{
+    VertexFormat format;
+    std::vector<unsigned char> data;
+    size_t vertexCount;
+};
+
+// 压缩交错的 float 顶点: 每个顶点 stride 个 float, 位置在开头,
+// normalOffset / texCoordOffset 为法线和纹理坐标的 float 偏移, -1 表示没有该属性.
+// halfPosition 为 true 时位置存为 half(适合尺寸不大的网格, 误差约为坐标值的 1/2048)
+// texCoordType 为 0 时按数据自动选择, 否则强制使用该类型(放进同一个 GeometryPool 的网格格式必须相同)
+void packVertices(const float *vertices, size_t vertexCount, int stride, int normalOffset, int texCoordOffset, bool halfPosition, PackedVertices &packed, GLenum texCoordType = 0);
+// 按 format 压缩一个顶点写到 dst(format.stride 字节), normal / texCoord 为 NULL 时写 0
+void packVertex(const VertexFormat &format, const float *position, const float *normal, const float *texCoord, unsigned char *dst);
+
+// 索引类型: 顶点数不超过 65536 时用 16 位索引(带图元重启时 0xFFFF 留作重启标记), 否则 32 位
+GLenum indexTypeFor(size_t vertexCount, bool primitiveRestart = false);
+size_t indexSize(GLenum indexType);
+GLuint restartIndexFor(GLenum indexType);
+// 按 indexType 把 32 位索引追加到 out(字节), MESH_RESTART_INDEX 换成该类型的重启标记
+void appendIndices(const unsigned int *indices, size_t count, GLenum indexType, std::vector<unsigned char> &out);
+
+// 八面体法线编码/解码(解码用于校验, 与着色器中的 octDecode 相同)
+void octEncode(float x, float y, float z, int16_t encoded[2]);
+void octDecode(const int16_t encoded[2], float normal[3]);
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+
+#endif /* vertexFormat_hpp */
@@ -6,41 +6,73 @@
 //
 
 #include "shader.hpp"
+#include "../vfs/assetPack.hpp"
+
+#include <string.h>
 
 using namespace std;
 
+// 展开源码中的 #include "文件名"(相对于当前着色器所在的目录, 不递归), 共用的函数只写一份.
+// 展开处前后插入 #line, 编译错误的行号仍对应原文件(被包含的文件为源串 1).
+// 没有 #include 时返回 false, 调用者直接使用映射的源码, 不做拷贝
+static bool expandIncludes(const char *path, const char *source, size_t length, string &expanded){
+    string directory = path;
+    size_t slash = directory.find_last_of('/');
+    directory = slash == string::npos ? "" : directory.substr(0, slash + 1);
+    bool found = false;
+    int line = 1;
+    size_t begin = 0;
+    while (begin < length) {
+        const char *end = (const char *)memchr(source + begin, '\n', length - begin);
+        size_t next = end != NULL ? (size_t)(end - source) + 1 : length;
+        string text(source + begin, next - begin);
+        size_t start = text.find_first_not_of(" \t");
+        size_t open = text.find('"');
+        size_t close = open == string::npos ? string::npos : text.find('"', open + 1);
+        if (start != string::npos && text.compare(start, 8, "#include") == 0 && close != string::npos) {
+            string file = directory + text.substr(open + 1, close - open - 1);
+            AssetFile included(file.c_str());
+            if (!included.valid())
+                cout << "ERROR::SHADER::INCLUDE_NOT_FOUND " << file << endl;
+            expanded += "#line 1 1\n";
+            expanded.append((const char *)included.data(), included.valid() ? included.size() : 0);
+            expanded += "\n#line " + to_string(line + 1) + " 0\n";
+            found = true;
+        }else{
+            expanded += text;
+        }
+        begin = next;
+        line++;
+    }
+    return found;
+}
+
 
 Shader::Shader(void){
     cout << "shader is construct.." << endl;
 }
 
 Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath){
-    string vertexCode;
-    string fragmentCode;
-    ifstream vShaderFile;
-    ifstream fShaderFile;
-    
-    vShaderFile.exceptions(ifstream::failbit | ifstream::badbit);
-    fShaderFile.exceptions(ifstream::failbit | ifstream::badbit);
-    
-    try {
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        stringstream vShaderStream, fShaderStream;
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // 关闭文件
-        vShaderFile.close();
-        fShaderFile.close();
-        // 将流存入字符串中
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-    } catch (ifstream::failure e) {
+    // 优先从资源包中零拷贝读取, 没有资源包时读取磁盘文件
+    AssetFile vShaderFile(vertexPath);
+    AssetFile fShaderFile(fragmentPath);
+    if (!vShaderFile.valid() || !fShaderFile.valid()) {
         cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << endl;
     }
-    // 返回着色器的源码
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+    // 返回着色器的源码(不以'\0'结尾, 需要同时传入长度)
+    const char* vShaderCode = vShaderFile.valid() ? (const char*)vShaderFile.data() : "";
+    const char* fShaderCode = fShaderFile.valid() ? (const char*)fShaderFile.data() : "";
+    GLint vShaderLength = (GLint)vShaderFile.size();
+    GLint fShaderLength = (GLint)fShaderFile.size();
+    string vExpanded, fExpanded;
+    if (expandIncludes(vertexPath, vShaderCode, vShaderLength, vExpanded)) {
+        vShaderCode = vExpanded.c_str();
+        vShaderLength = (GLint)vExpanded.size();
+    }
+    if (expandIncludes(fragmentPath, fShaderCode, fShaderLength, fExpanded)) {
+        fShaderCode = fExpanded.c_str();
+        fShaderLength = (GLint)fExpanded.size();
+    }
     
     unsigned int vertex, fragment;
     int success;
@@ -48,7 +80,7 @@ Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath){
     
     // 顶点着色器
     vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
+    glShaderSource(vertex, 1, &vShaderCode, &vShaderLength);
     glCompileShader(vertex);
     // 打印编译错误
     glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
@@ -59,7 +91,7 @@ Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath){
     
     // 片段着色器
     fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
+    glShaderSource(fragment, 1, &fShaderCode, &fShaderLength);
     glCompileShader(fragment);
     glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
     if (!success) {
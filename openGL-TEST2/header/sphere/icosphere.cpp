@@ -0,0 +1,228 @@
+//
+//  icosphere.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/29.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "icosphere.hpp"
+#include "sphere.hpp"
+#include "../util/flatHashMap.hpp"
+
+#include <float.h>
+
+using namespace std;
+
+Icosphere::Icosphere(float radius, int subdivisions, bool smooth){
+    set(radius, subdivisions, smooth);
+}
+
+void Icosphere::set(float radius, int subdivisions, bool smooth){
+    this->radius = radius;
+    this->subdivisions = subdivisions;
+    this->smooth = smooth; // 同 Sphere, 只有平滑法线
+    positions.clear();
+    vertices.clear();
+    indices.clear();
+    subdivide();
+    buildVertices();
+}
+
+const std::vector<float> &Icosphere::getVertices() const{
+    return this->vertices;
+}
+
+const std::vector<unsigned int> &Icosphere::getIndices() const{
+    return this->indices;
+}
+
+// 两点中点投影到单位球面, 同一条边只生成一次
+static unsigned int midpoint(vector<float> &positions, FlatHashMap<unsigned int> &edges, unsigned int a, unsigned int b){
+    uint64_t key = a < b ? ((uint64_t)a << 32 | b) : ((uint64_t)b << 32 | a);
+    unsigned int *found = edges.find(key);
+    if (found != NULL)
+        return *found;
+    float x = positions[a * 3] + positions[b * 3];
+    float y = positions[a * 3 + 1] + positions[b * 3 + 1];
+    float z = positions[a * 3 + 2] + positions[b * 3 + 2];
+    float lenInv = 1.0f / sqrtf(x * x + y * y + z * z);
+    unsigned int index = (unsigned int)(positions.size() / 3);
+    positions.push_back(x * lenInv);
+    positions.push_back(y * lenInv);
+    positions.push_back(z * lenInv);
+    edges.insert(key, index);
+    return index;
+}
+
+void Icosphere::subdivide(){
+    // 正二十面体: 12 个顶点, 20 个面(逆时针朝外)
+    const float t = (1.0f + sqrtf(5.0f)) / 2.0f;
+    const float base[12][3] = {
+        {-1,  t,  0}, { 1,  t,  0}, {-1, -t,  0}, { 1, -t,  0},
+        { 0, -1,  t}, { 0,  1,  t}, { 0, -1, -t}, { 0,  1, -t},
+        { t,  0, -1}, { t,  0,  1}, {-t,  0, -1}, {-t,  0,  1}
+    };
+    const unsigned int faces[20][3] = {
+        {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+        {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+        {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+        {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+    };
+    // 细分 n 次后: 顶点 10*4^n+2, 三角形 20*4^n
+    size_t finalVertices = 10 * ((size_t)1 << (2 * subdivisions)) + 2;
+    positions.reserve(finalVertices * 3);
+    float lenInv = 1.0f / sqrtf(1.0f + t * t);
+    for (int i = 0; i < 12; i++)
+        for (int k = 0; k < 3; k++)
+            positions.push_back(base[i][k] * lenInv);
+    indices.assign(&faces[0][0], &faces[0][0] + 60);
+
+    FlatHashMap<unsigned int> edges;
+    vector<unsigned int> next;
+    for (int level = 0; level < subdivisions; level++) {
+        next.clear();
+        next.reserve(indices.size() * 4);
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            unsigned int ab = midpoint(positions, edges, a, b);
+            unsigned int bc = midpoint(positions, edges, b, c);
+            unsigned int ca = midpoint(positions, edges, c, a);
+            unsigned int tris[12] = {a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca};
+            next.insert(next.end(), tris, tris + 12);
+        }
+        indices.swap(next);
+        edges.clear();
+    }
+}
+
+void Icosphere::buildVertices(){
+    // 与 Sphere 相同的经纬度展开: z 轴向上, s = 经度 / 2pi, t = 0.5 - 纬度 / pi
+    size_t count = positions.size() / 3;
+    vector<float> u(count), v(count);
+    vector<bool> pole(count);
+    for (size_t i = 0; i < count; i++) {
+        float x = positions[i * 3], y = positions[i * 3 + 1], z = positions[i * 3 + 2];
+        float s = atan2f(y, x) / (float)(2 * PI);
+        u[i] = s < 0.0f ? s + 1.0f : s;
+        v[i] = 0.5f - asinf(fmaxf(-1.0f, fminf(1.0f, z))) / (float)PI;
+        pole[i] = fabsf(x) < 1e-6f && fabsf(y) < 1e-6f;
+    }
+
+    // 接缝与极点需要额外的顶点, 先复制已有的(下标不变), 新顶点追加在后面
+    vector<unsigned int> sources;   // 追加顶点对应的原顶点
+    FlatHashMap<unsigned int> seamCopies;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        unsigned int *tri = &indices[i];
+        float minU = 1.0f, maxU = 0.0f;
+        for (int k = 0; k < 3; k++) {
+            if (pole[tri[k]])
+                continue;
+            minU = fminf(minU, u[tri[k]]);
+            maxU = fmaxf(maxU, u[tri[k]]);
+        }
+        // 跨过接缝: u 小的一侧改用 u+1 的复制顶点, 让纹理坐标在三角形内连续
+        if (maxU - minU > 0.5f) {
+            for (int k = 0; k < 3; k++) {
+                unsigned int index = tri[k];
+                if (pole[index] || u[index] >= 0.5f)
+                    continue;
+                unsigned int *copy = seamCopies.find(index);
+                if (copy == NULL) {
+                    unsigned int created = (unsigned int)u.size();
+                    u.push_back(u[index] + 1.0f);
+                    v.push_back(v[index]);
+                    pole.push_back(false);
+                    sources.push_back(index);
+                    copy = &seamCopies.insert(index, created);
+                }
+                tri[k] = *copy;
+            }
+        }
+        // 极点的 u 没有定义, 每个三角形单独复制一份, 取另外两个顶点 u 的平均
+        for (int k = 0; k < 3; k++) {
+            unsigned int index = tri[k];
+            if (!pole[index])
+                continue;
+            unsigned int a = tri[(k + 1) % 3], b = tri[(k + 2) % 3];
+            unsigned int created = (unsigned int)u.size();
+            u.push_back((u[a] + u[b]) * 0.5f);
+            v.push_back(v[index]);
+            pole.push_back(true);
+            sources.push_back(index);
+            tri[k] = created;
+        }
+    }
+
+    size_t total = u.size();
+    vertices.reserve(total * 8);
+    for (size_t i = 0; i < total; i++) {
+        size_t source = i < count ? i : sources[i - count];
+        const float *p = &positions[source * 3];
+        vertices.push_back(p[0] * radius);
+        vertices.push_back(p[1] * radius);
+        vertices.push_back(p[2] * radius);
+        vertices.push_back(p[0]);
+        vertices.push_back(p[1]);
+        vertices.push_back(p[2]);
+        vertices.push_back(u[i]);
+        vertices.push_back(v[i]);
+    }
+    positions.clear();
+    positions.shrink_to_fit();
+}
+
+// 三角形 abc 上离原点最近的点(Ericson, Real-Time Collision Detection 5.1.5)
+static void closestToOrigin(const float *a, const float *b, const float *c, float out[3]){
+    float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    float ap[3] = {-a[0], -a[1], -a[2]};
+    float d1 = ab[0] * ap[0] + ab[1] * ap[1] + ab[2] * ap[2];
+    float d2 = ac[0] * ap[0] + ac[1] * ap[1] + ac[2] * ap[2];
+    if (d1 <= 0.0f && d2 <= 0.0f) { for (int k = 0; k < 3; k++) out[k] = a[k]; return; }
+    float bp[3] = {-b[0], -b[1], -b[2]};
+    float d3 = ab[0] * bp[0] + ab[1] * bp[1] + ab[2] * bp[2];
+    float d4 = ac[0] * bp[0] + ac[1] * bp[1] + ac[2] * bp[2];
+    if (d3 >= 0.0f && d4 <= d3) { for (int k = 0; k < 3; k++) out[k] = b[k]; return; }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        float w = d1 / (d1 - d3);
+        for (int k = 0; k < 3; k++) out[k] = a[k] + w * ab[k];
+        return;
+    }
+    float cp[3] = {-c[0], -c[1], -c[2]};
+    float d5 = ab[0] * cp[0] + ab[1] * cp[1] + ab[2] * cp[2];
+    float d6 = ac[0] * cp[0] + ac[1] * cp[1] + ac[2] * cp[2];
+    if (d6 >= 0.0f && d5 <= d6) { for (int k = 0; k < 3; k++) out[k] = c[k]; return; }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        float w = d2 / (d2 - d6);
+        for (int k = 0; k < 3; k++) out[k] = a[k] + w * ac[k];
+        return;
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        for (int k = 0; k < 3; k++) out[k] = b[k] + w * (c[k] - b[k]);
+        return;
+    }
+    float denom = 1.0f / (va + vb + vc);
+    float v = vb * denom, w = vc * denom;
+    for (int k = 0; k < 3; k++) out[k] = a[k] + ab[k] * v + ac[k] * w;
+}
+
+float sphereSurfaceError(const float *vertices, int stride, const unsigned int *indices, size_t indexCount, float radius, float *mean){
+    float maxError = 0.0f;
+    double sum = 0.0;
+    size_t triangles = indexCount / 3;
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        float p[3];
+        closestToOrigin(vertices + indices[i] * stride, vertices + indices[i + 1] * stride, vertices + indices[i + 2] * stride, p);
+        float error = radius - sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        maxError = fmaxf(maxError, error);
+        sum += error;
+    }
+    if (mean != NULL)
+        *mean = triangles > 0 ? (float)(sum / triangles) : 0.0f;
+    return maxError;
+}
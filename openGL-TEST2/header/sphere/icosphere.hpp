@@ -0,0 +1,50 @@
+//
+//  icosphere.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/29.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef ICOSPHERE_H
+#define ICOSPHERE_H
+
+#include <iostream>
+#include <math.h>
+#include <vector>
+
+// 测地线球: 正二十面体每次细分把一个三角形分成四个, 新顶点投影回球面.
+// 三角形大小均匀, 没有 UV 球两极的细长三角形, 同样的轮廓误差需要的三角形少得多.
+// 顶点布局与 Sphere 相同: 位置(3) 法线(3) 纹理坐标(2), 纹理坐标按经纬度展开(与 Sphere 一致),
+// 跨过 u=0/1 接缝的三角形复制顶点并把 u 加 1, 极点顶点按三角形复制并取相邻顶点 u 的平均.
+class Icosphere{
+public:
+
+    Icosphere(float radius=1.0f, int subdivisions=3, bool smooth=true);
+    ~Icosphere() {};
+
+    void set(float radius, int subdivisions, bool smooth=true);
+
+    // 返回引用, 不拷贝; 在 Icosphere 析构或重新 set 之前有效
+    const std::vector<float> &getVertices() const;
+    const std::vector<unsigned int> &getIndices() const;
+
+private:
+    float radius;
+    int subdivisions;
+    bool smooth;
+    std::vector<float> positions;          // 细分后的单位球面顶点
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    // 细分正二十面体, 生成 positions 与 indices
+    void subdivide();
+    // 展开纹理坐标(处理接缝与极点), 生成交错顶点并改写 indices
+    void buildVertices();
+};
+
+// 三角网格与半径为 radius 的球面之间的最大径向误差(每个三角形上离球心最近的点到球面的距离),
+// mean 不为 NULL 时返回各三角形误差的平均值. 顶点为 stride 个 float 一个, 位置在开头.
+float sphereSurfaceError(const float *vertices, int stride, const unsigned int *indices, size_t indexCount, float radius, float *mean = NULL);
+
+#endif /* icosphere_hpp */
@@ -7,85 +7,148 @@
 //
 
 #include "sphere.hpp"
+#include "../util/workerPool.hpp"
 
-Sphere::Sphere(float radius, int sectorCount, int stackCount, bool smooth){
-    set(radius, sectorCount, stackCount, smooth);
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// 每段至少分到这么多顶点, 否则分派的开销比生成还大
+static const size_t SPHERE_MIN_VERTICES_PER_THREAD = 64 * 1024;
+
+Sphere::Sphere(float radius, int sectorCount, int stackCount, bool smooth, int threads){
+    set(radius, sectorCount, stackCount, smooth, threads);
 }
 
-void Sphere::set(float radius, int sectorCount, int stackCount, bool smooth){
+void Sphere::set(float radius, int sectorCount, int stackCount, bool smooth, int threads){
     this->radius = radius;
     this->sectorCount = sectorCount;
     this->stackCount = stackCount;
     this->smooth = smooth; // Not achive it.
+    this->threads = threads;
+    vertices.clear();
+    normals.clear();
+    indices.clear();
     buildVertices();
     buildIndices();
 }
 
-std::vector<float> Sphere::getVertices(){
+const std::vector<float> &Sphere::getVertices() const{
     return this->vertices;
 }
 
-std::vector<unsigned int> Sphere::getIndices(){
+const std::vector<unsigned int> &Sphere::getIndices() const{
     return this->indices;
 }
 
+int Sphere::threadCount() const{
+    int count = workerThreadCount(threads);
+    size_t vertexCount = (size_t)(stackCount + 1) * (sectorCount + 1);
+    count = min(count, (int)(vertexCount / SPHERE_MIN_VERTICES_PER_THREAD) + 1);
+    return max(1, min(count, stackCount + 1));
+}
 
 void Sphere::buildVertices(){
     float sectorStep = (2*PI)/sectorCount; // 横向每份的角度 算出弧度值
+    // 每个经度角在所有行里重复出现, sin/cos 只算一次
+    vector<float> sectorCos(sectorCount + 1), sectorSin(sectorCount + 1);
+    for (int j = 0; j <= sectorCount; j++) {
+        float sectorAngle = sectorStep * j;
+        sectorCos[j] = cosf(sectorAngle);
+        sectorSin[j] = sinf(sectorAngle);
+    }
+    // 顶点数是确定的, 先一次分配好, 各行直接写到自己的位置
+    vertices.resize((size_t)(stackCount + 1) * (sectorCount + 1) * 8);
+    parallelRows(stackCount + 1, threadCount(), [&](int first, int last){
+        buildVertexRows(first, last, &sectorCos[0], &sectorSin[0]);
+    });
+}
+
+void Sphere::buildVertexRows(int first, int last, const float *sectorCos, const float *sectorSin){
     float stackStep = PI/stackCount;    // 纵向每份的角度        算出弧度值
-    float sectorAngle, stackAngle;    // 当前横向, 纵向角度
-    float s, t;
-    float nx, ny, nz, lenInv = radius / 1.0f; // vertex normal
-    
-    for (float i = 0; i <= stackCount; i++ )
+    float lenInv = 1.0f / radius;       // vertex normal
+    float sectors = (float)sectorCount;
+    for (int i = first; i < last; i++)
     {
-        stackAngle = PI/2 - i*stackStep;
-        float z = radius * sin(stackAngle);
-        float xy = radius * cos(stackAngle);
-        for (float j = 0; j <= sectorCount; j++)
+        float stackAngle = PI/2 - i*stackStep;
+        float z = radius * sinf(stackAngle);
+        float xy = radius * cosf(stackAngle);
+        float nz = z * lenInv;
+        // texture coordinate range between [0,0]->[1,1]
+        float t = (float)i / stackCount;
+        float *dst = &vertices[(size_t)i * (sectorCount + 1) * 8];
+        int j = 0;
+#if defined(__SSE2__)
+        // 一次 4 个顶点: 按分量算好后转置成 4 个交错顶点(每个 8 个 float)
+        __m128 xy4 = _mm_set1_ps(xy), lenInv4 = _mm_set1_ps(lenInv), z4 = _mm_set1_ps(z);
+        __m128 nz4 = _mm_set1_ps(nz), t4 = _mm_set1_ps(t), sectors4 = _mm_set1_ps(sectors);
+        for (; j + 4 <= sectorCount + 1; j += 4, dst += 32) {
+            __m128 x = _mm_mul_ps(xy4, _mm_loadu_ps(sectorCos + j));
+            __m128 y = _mm_mul_ps(xy4, _mm_loadu_ps(sectorSin + j));
+            __m128 nx = _mm_mul_ps(x, lenInv4);
+            __m128 ny = _mm_mul_ps(y, lenInv4);
+            __m128 s = _mm_div_ps(_mm_cvtepi32_ps(_mm_setr_epi32(j, j + 1, j + 2, j + 3)), sectors4);
+            __m128 a0 = x, a1 = y, a2 = z4, a3 = nx;
+            __m128 b0 = ny, b1 = nz4, b2 = s, b3 = t4;
+            _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+            _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+            _mm_storeu_ps(dst, a0);      _mm_storeu_ps(dst + 4, b0);
+            _mm_storeu_ps(dst + 8, a1);  _mm_storeu_ps(dst + 12, b1);
+            _mm_storeu_ps(dst + 16, a2); _mm_storeu_ps(dst + 20, b2);
+            _mm_storeu_ps(dst + 24, a3); _mm_storeu_ps(dst + 28, b3);
+        }
+#endif
+        for (; j <= sectorCount; j++, dst += 8)
         {
-            sectorAngle = sectorStep * j;
-            float x = xy * cos(sectorAngle);
-            float y = xy * sin(sectorAngle);
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-            
-            nx = x * lenInv;
-            ny = y * lenInv;
-            nz = z * lenInv;
-            vertices.push_back(nx);
-            vertices.push_back(ny);
-            vertices.push_back(nz);
-            
-            // texture coordinate range between [0,0]->[1,1]
-            s = (float)j / sectorCount;
-            t = (float)i / stackCount;
-            texCoords.push_back(s);
-            texCoords.push_back(t);
+            float x = xy * sectorCos[j];
+            float y = xy * sectorSin[j];
+            dst[0] = x;
+            dst[1] = y;
+            dst[2] = z;
+            dst[3] = x * lenInv;
+            dst[4] = y * lenInv;
+            dst[5] = nz;
+            dst[6] = (float)j / sectorCount;
+            dst[7] = t;
         }
     }
 }
 
 
 void Sphere::buildIndices(){
-    int k1, k2;
-    //    vector<float> vbo = drawglobeVBO();
-    for (int i = 0; i < stackCount; i++)
+    // 两极各少一圈三角形
+    indices.resize((size_t)sectorCount * (stackCount > 1 ? stackCount * 2 - 2 : 0) * 3);
+    if (indices.empty())
+        return;
+    parallelRows(stackCount, threadCount(), [&](int first, int last){
+        buildIndexRows(first, last);
+    });
+}
+
+void Sphere::buildIndexRows(int first, int last){
+    for (int i = first; i < last; i++)
     {
-        k1 = i * (sectorCount + 1);
-        k2 = k1 + sectorCount + 1;
-        for (int j = 0;j < sectorCount; j++, k1++, k2++)
+        // 第 0 行只有下半个四边形, 最后一行只有上半个, 前面各行的三角形数可以直接算出
+        bool upper = i != 0, lower = i != (stackCount - 1);
+        size_t before = (size_t)sectorCount * (i > 0 ? 2 * i - 1 : 0);
+        unsigned int *dst = &indices[before * 3];
+        unsigned int k1 = (unsigned int)i * (sectorCount + 1);
+        unsigned int k2 = k1 + sectorCount + 1;
+        for (int j = 0; j < sectorCount; j++, k1++, k2++)
         {
-            if (i != 0) {
-                indices.push_back(k1);
-                indices.push_back(k2);
-                indices.push_back(k1+1);
+            if (upper) {
+                dst[0] = k1;
+                dst[1] = k2;
+                dst[2] = k1+1;
+                dst += 3;
             }
-            if (i != (stackCount - 1)) {
-                indices.push_back(k1+1);
-                indices.push_back(k2);
-                indices.push_back(k2+1);
+            if (lower) {
+                dst[0] = k1+1;
+                dst[1] = k2;
+                dst[2] = k2+1;
+                dst += 3;
             }
         }
     }
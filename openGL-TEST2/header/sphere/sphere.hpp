@@ -15,18 +15,22 @@
 
 #define PI 3.1415926
 
+// 顶点按行(stack)生成: 每个经度角的 sin/cos 只算一次, 各行并行写入预先分配好的缓冲,
+// 索引按行号直接算出写入位置, 同样按行并行. threads 为0时按顶点数自动决定线程数.
 class Sphere{
 public:
     
-    Sphere(float radius=1.0f, int sectorCount=60, int stackCount=60, bool smooth=true);
+    Sphere(float radius=1.0f, int sectorCount=60, int stackCount=60, bool smooth=true, int threads=0);
     ~Sphere() {};
     
-    void set(float radius, int sectorCount, int stackCount, bool smooth=true);
+    void set(float radius, int sectorCount, int stackCount, bool smooth=true, int threads=0);
     void buildVertices();
     void buildIndices();
     
-    std::vector<float> getVertices();
-    std::vector<unsigned int> getIndices();
+    // 返回引用, 不拷贝; 在 Sphere 析构或重新 set 之前有效
+    // 顶点交错存放: 位置(3) 法线(3) 纹理坐标(2), 与立方体、地板的布局相同
+    const std::vector<float> &getVertices() const;
+    const std::vector<unsigned int> &getIndices() const;
     
 private:
     // memeber vars
@@ -34,10 +38,16 @@ private:
     int sectorCount;                        // longitude, # of slices
     int stackCount;                         // latitude, # of stacks
     bool smooth;
+    int threads;
     std::vector<float> vertices;
     std::vector<float> normals;
-    std::vector<float> texCoords;
     std::vector<unsigned int> indices;
+
+    // 实际使用的线程数
+    int threadCount() const;
+    // 生成第 [first, last) 行的顶点 / 第 [first, last) 行之间的三角形
+    void buildVertexRows(int first, int last, const float *sectorCos, const float *sectorSin);
+    void buildIndexRows(int first, int last);
 };
 
 #endif /* sphere_hpp */
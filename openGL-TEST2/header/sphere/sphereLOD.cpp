@@ -0,0 +1,134 @@
+//
+//  sphereLOD.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/28.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "sphereLOD.hpp"
+#include "icosphere.hpp"
+
+#include <math.h>
+#include <float.h>
+
+using namespace std;
+
+SphereLOD::SphereLOD() : maxError(0.5f), hysteresis(0.6f), useStrips(false), pool(NULL), radius(0.0f){
+}
+
+void SphereLOD::create(GeometryPool &pool, MeshCache &cache, float radius, const int *segments, int levelCount){
+    vector<MeshView> meshes(levelCount);
+    vector<float> sags(levelCount);
+    for (int i = 0; i < levelCount; i++) {
+        meshes[i] = cache.sphere(radius, segments[i], max(2, segments[i] / 2));
+        sags[i] = 1.0f - cosf((float)PI / segments[i]);
+    }
+    upload(pool, meshes, segments, sags);
+    this->radius = radius;
+}
+
+void SphereLOD::createIcosphere(GeometryPool &pool, MeshCache &cache, float radius, const int *subdivisions, int levelCount){
+    vector<MeshView> meshes(levelCount);
+    vector<float> sags(levelCount);
+    for (int i = 0; i < levelCount; i++) {
+        meshes[i] = cache.icosphere(radius, subdivisions[i]);
+        // 测地线球的误差没有简单的闭式, 直接对网格量一遍
+        sags[i] = sphereSurfaceError(meshes[i].vertices.data, meshes[i].stride, meshes[i].indices.data, meshes[i].indices.size, radius) / radius;
+    }
+    upload(pool, meshes, subdivisions, sags);
+    this->radius = radius;
+}
+
+void SphereLOD::upload(GeometryPool &pool, const vector<MeshView> &meshes, const int *segments, const vector<float> &sags){
+    release();
+    this->pool = &pool;
+    vector<unsigned int> strips;
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const unsigned int *indices = meshes[i].indices.data;
+        size_t count = meshes[i].indices.size;
+        if (useStrips) {
+            stripify(indices, count, strips);
+            indices = strips.empty() ? NULL : &strips[0];
+            count = strips.size();
+        }
+        Level level;
+        level.segments = segments[i];
+        level.sag = sags[i];
+        // 索引已经过顶点缓存优化, 按顺序切分得到的簇是连续的一片球面
+        if (!useStrips)
+            buildMeshlets(indices, count, meshes[i].vertices.data, meshes[i].vertexCount(), meshes[i].stride, level.meshlets);
+        if (!pool.add(meshes[i].vertices.data, meshes[i].vertexCount(), meshes[i].stride, indices, count, level.range, useStrips ? GL_TRIANGLE_STRIP : GL_TRIANGLES))
+            break;
+        levels.push_back(level);
+    }
+}
+
+float SphereLOD::projectedRadius(const glm::vec3 &center, float radius, const glm::mat4 &view, const glm::mat4 &projection, float viewportHeight){
+    glm::vec4 viewCenter = view * glm::vec4(center, 1.0f);
+    float distance2 = viewCenter.x * viewCenter.x + viewCenter.y * viewCenter.y + viewCenter.z * viewCenter.z;
+    // 相机在球内时按最高精度处理
+    if (distance2 <= radius * radius)
+        return FLT_MAX;
+    // 透视投影下球的视角半径为 asin(r / d), 屏幕上的半径为 tan(视角半径) * cot(fovy/2) * 半屏高
+    return radius / sqrtf(distance2 - radius * radius) * projection[1][1] * viewportHeight * 0.5f;
+}
+
+float SphereLOD::projectedRadius(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection, float viewportHeight) const{
+    glm::vec3 center(model[3][0], model[3][1], model[3][2]);
+    float scale = 0.0f;
+    for (int i = 0; i < 3; i++)
+        scale = fmaxf(scale, sqrtf(model[i][0] * model[i][0] + model[i][1] * model[i][1] + model[i][2] * model[i][2]));
+    return projectedRadius(center, radius * scale, view, projection, viewportHeight);
+}
+
+int SphereLOD::select(float pixelRadius, int current) const{
+    int count = (int)levels.size();
+    if (count == 0)
+        return -1;
+    // 误差满足要求的最粗一级
+    int wanted = count - 1;
+    for (int i = 0; i < count; i++) {
+        if (pixelRadius * levels[i].sag <= maxError) {
+            wanted = i;
+            break;
+        }
+    }
+    if (current < 0 || current >= count || wanted > current)
+        return wanted;
+    // 变粗: 只有更粗一级的误差明显小于阈值时才切换
+    int level = current;
+    while (level > wanted && pixelRadius * levels[level - 1].sag <= maxError * hysteresis)
+        level--;
+    return level;
+}
+
+void SphereLOD::draw(int level) const{
+    if (pool == NULL || level < 0 || level >= (int)levels.size())
+        return;
+    pool->draw(levels[level].range);
+}
+
+size_t SphereLOD::drawCulled(int level, const glm::mat4 &modelViewProjection) const{
+    if (pool == NULL || level < 0 || level >= (int)levels.size())
+        return 0;
+    // 只有一个簇时剔除不划算
+    if (levels[level].meshlets.size() <= 1) {
+        pool->draw(levels[level].range);
+        return levels[level].meshlets.size();
+    }
+    MeshletCuller culler;
+    culler.setup(modelViewProjection);
+    return pool->drawCulled(levels[level].range, levels[level].meshlets, culler);
+}
+
+size_t SphereLOD::indexBytes() const{
+    size_t bytes = 0;
+    for (size_t i = 0; i < levels.size(); i++)
+        bytes += levels[i].range.indexCount * indexSize(pool->indexType());
+    return bytes;
+}
+
+void SphereLOD::release(){
+    levels.clear();
+}
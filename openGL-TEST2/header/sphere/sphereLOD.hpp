@@ -0,0 +1,73 @@
+//
+//  sphereLOD.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/28.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef SPHERE_LOD_H
+#define SPHERE_LOD_H
+
+#include <iostream>
+#include <vector>
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "../mesh/meshCache.hpp"
+#include "../mesh/vertexFormat.hpp"
+#include "../mesh/geometryPool.hpp"
+#include "../mesh/meshlet.hpp"
+
+// 球体的离散 LOD 链: 各级(如 8, 16, 32, 64, 128 段)加入同一个 GeometryPool,
+// 每级用 glDrawElementsBaseVertex 绘制, 切换级别不需要换VAO(绘制前由调用者 bind 池).
+// 级别按投影到屏幕上的半径(像素)选择: 取轮廓误差不超过 maxError 像素的最粗一级,
+// 变粗时要求误差再小一截(hysteresis), 避免在阈值附近来回跳.
+// 索引类型由池决定(16 位时每级不能超过 65535 个顶点); useStrips 时索引转成带图元重启的三角形带.
+// 三角形列表的每级同时切成 meshlet, drawCulled 按 pass 剔除背面和视锥外的簇(约一半的球面).
+class SphereLOD{
+public:
+    struct Level{
+        int segments;       // 经向分段数, 纬向为一半(测地线球为细分次数)
+        GeometryRange range;
+        float sag;          // 单位半径的轮廓误差, UV 球为 1 - cos(pi / segments)
+        std::vector<Meshlet> meshlets;  // 三角形带时为空
+    };
+
+    float maxError;         // 允许的轮廓误差(像素)
+    float hysteresis;       // 变粗时误差需低于 maxError * hysteresis
+    bool useStrips;         // 用三角形带 + 图元重启绘制, 需在 create 之前设置
+
+    SphereLOD();
+
+    // 从 MeshCache 取各级球体加入 pool(需要GL上下文); segments 从粗到细
+    void create(GeometryPool &pool, MeshCache &cache, float radius, const int *segments, int levelCount);
+    // 同上, 各级换成测地线球, subdivisions 从粗到细
+    void createIcosphere(GeometryPool &pool, MeshCache &cache, float radius, const int *subdivisions, int levelCount);
+    // 球心 center、半径 radius(世界空间)投影到屏幕上的半径, 单位像素
+    static float projectedRadius(const glm::vec3 &center, float radius, const glm::mat4 &view, const glm::mat4 &projection, float viewportHeight);
+    // 同上, 球心和半径从绘制用的 model 矩阵推出(平移为球心, 半径乘以最大的轴向缩放), 不必另外抄一份变换
+    float projectedRadius(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection, float viewportHeight) const;
+    // 按投影半径选择级别, current 为该物体上一帧的级别(没有时传 -1)
+    int select(float pixelRadius, int current) const;
+    // 绘制某一级, 池的VAO需已绑定
+    void draw(int level) const;
+    // 按 meshlet 剔除后绘制, modelViewProjection 为当前 pass(相机或光源)的变换; 返回画出的簇数
+    size_t drawCulled(int level, const glm::mat4 &modelViewProjection) const;
+    // 只清空级别, 数据留在池中直到池释放
+    void release();
+
+    int levelCount() const { return (int)levels.size(); }
+    size_t indexBytes() const;
+    const Level &level(int i) const { return levels[i]; }
+
+private:
+    std::vector<Level> levels;
+    GeometryPool *pool;
+    float radius;           // 网格的半径(模型空间)
+
+    void upload(GeometryPool &pool, const std::vector<MeshView> &meshes, const int *segments, const std::vector<float> &sags);
+};
+
+#endif /* sphereLOD_hpp */
@@ -0,0 +1,118 @@
+//
+//  bindlessTable.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/13.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "bindlessTable.hpp"
+
+using namespace std;
+
+bool BindlessTextureTable::isSupported(){
+    return GLEW_ARB_bindless_texture && GLEW_ARB_shader_storage_buffer_object;
+}
+
+BindlessTextureTable::BindlessTextureTable() : ssbo(0), dirty(false), budget(256 * 1024 * 1024), resident_bytes(0), frame(0){
+}
+
+void BindlessTextureTable::setBudget(size_t bytes){
+    budget = bytes;
+    evict(0);
+}
+
+int BindlessTextureTable::add(GLuint textureID){
+    Entry entry;
+    entry.textureID = textureID;
+    entry.handle = glGetTextureHandleARB(textureID);
+    entry.bytes = textureBytes(textureID);
+    entry.resident = false;
+    entry.lastUsed = 0;
+    entries.push_back(entry);
+    dirty = true;
+    return (int)entries.size() - 1;
+}
+
+void BindlessTextureTable::beginFrame(){
+    frame++;
+    if (dirty)
+        upload();
+}
+
+void BindlessTextureTable::request(int materialID){
+    if (materialID < 0 || materialID >= (int)entries.size())
+        return;
+    Entry &entry = entries[materialID];
+    entry.lastUsed = frame;
+    if (entry.resident)
+        return;
+    evict(entry.bytes);
+    glMakeTextureHandleResidentARB(entry.handle);
+    entry.resident = true;
+    resident_bytes += entry.bytes;
+}
+
+void BindlessTextureTable::bind(GLuint binding){
+    if (dirty)
+        upload();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, ssbo);
+}
+
+void BindlessTextureTable::release(){
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].resident)
+            glMakeTextureHandleNonResidentARB(entries[i].handle);
+    }
+    entries.clear();
+    resident_bytes = 0;
+    if (ssbo != 0)
+        glDeleteBuffers(1, &ssbo);
+    ssbo = 0;
+}
+
+void BindlessTextureTable::upload(){
+    // 句柄按材质ID顺序排列, 着色器中以 uvec2 读取
+    vector<GLuint64> handles(entries.size());
+    for (size_t i = 0; i < entries.size(); i++)
+        handles[i] = entries[i].handle;
+    if (ssbo == 0)
+        glGenBuffers(1, &ssbo);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, handles.size() * sizeof(GLuint64), handles.empty() ? NULL : &handles[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    dirty = false;
+}
+
+void BindlessTextureTable::evict(size_t needed){
+    // 按LRU换出本帧没有用到的句柄, 直到腾出 needed 字节
+    while (resident_bytes + needed > budget) {
+        int victim = -1;
+        for (size_t i = 0; i < entries.size(); i++) {
+            const Entry &e = entries[i];
+            if (!e.resident || e.lastUsed == frame)
+                continue;
+            if (victim == -1 || e.lastUsed < entries[victim].lastUsed)
+                victim = (int)i;
+        }
+        if (victim == -1) {
+            if (needed > 0)
+                cout << "WARNING::BINDLESS: Texture budget exceeded by frame " << frame << endl;
+            return;
+        }
+        glMakeTextureHandleNonResidentARB(entries[victim].handle);
+        entries[victim].resident = false;
+        resident_bytes -= entries[victim].bytes;
+    }
+}
+
+size_t BindlessTextureTable::textureBytes(GLuint textureID){
+    // 估算纹理占用: 按每像素4字节, mipmap 链再多 1/3
+    GLint width = 0, height = 0;
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    size_t base = (size_t)width * height * 4;
+    return base + base / 3;
+}
@@ -0,0 +1,61 @@
+//
+//  bindlessTable.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/13.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef BINDLESS_TABLE_H
+#define BINDLESS_TABLE_H
+
+#include <iostream>
+#include <vector>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+// ARB_bindless_texture 句柄表: 每张纹理对应一个64位句柄, 按材质ID存进SSBO,
+// 着色器直接用材质ID索引, 不再需要逐次 glBindTexture.
+// 常驻(resident)的纹理总字节数受 budget 限制, 超出时按LRU把本帧未使用的句柄换出.
+class BindlessTextureTable{
+public:
+    // 驱动是否同时支持 bindless texture 与 SSBO
+    static bool isSupported();
+
+    BindlessTextureTable();
+
+    // 设置常驻纹理的显存预算(字节)
+    void setBudget(size_t bytes);
+    // 注册由 loadTexture 生成的纹理, 返回材质ID
+    int add(GLuint textureID);
+    // 每帧开始时调用, 用于LRU计时
+    void beginFrame();
+    // 绘制前调用, 保证该材质的句柄常驻
+    void request(int materialID);
+    // 绑定句柄SSBO到指定的 binding 点
+    void bind(GLuint binding);
+    void release();
+
+    size_t residentBytes() const { return resident_bytes; }
+
+private:
+    struct Entry{
+        GLuint textureID;
+        GLuint64 handle;
+        size_t bytes;
+        bool resident;
+        unsigned long lastUsed;
+    };
+    std::vector<Entry> entries;
+    GLuint ssbo;
+    bool dirty;
+    size_t budget;
+    size_t resident_bytes;
+    unsigned long frame;
+
+    void upload();
+    void evict(size_t needed);
+    static size_t textureBytes(GLuint textureID);
+};
+
+#endif /* bindlessTable_hpp */
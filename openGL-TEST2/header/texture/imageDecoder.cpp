@@ -0,0 +1,238 @@
+//
+//  imageDecoder.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/15.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "imageDecoder.hpp"
+#include "../stb/stb_image.h"
+#include "../util/workerPool.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+
+// 小于这个像素数的图片不值得开线程
+static const long PARALLEL_MIN_PIXELS = 1024 * 1024;
+
+struct JpegLayout{
+    int width;
+    int height;
+    int mcuWidth;
+    int mcuHeight;
+    int restartInterval;       // 0 表示没有 DRI
+    size_t sofHeightOffset;    // SOF 中图片高度字段的偏移
+    size_t scanStart;          // SOS 段之后熵编码数据的起点
+    bool verticalSubsampling;  // 是否有分量在纵向下采样(如 4:2:0)
+};
+
+static void copyRows(const unsigned char *src, int y0, int rows, int width, int height, int channels, bool flip, unsigned char *dst){
+    size_t stride = (size_t)width * channels;
+    for (int r = 0; r < rows; r++) {
+        int y = y0 + r;
+        int dst_y = flip ? height - 1 - y : y;
+        memcpy(dst + dst_y * stride, src + r * stride, stride);
+    }
+}
+
+// 解析 baseline JPEG 的头部, 只接受单个交错扫描的 SOF0/SOF1
+static bool parseJpeg(const unsigned char *buf, size_t len, JpegLayout &layout){
+    if (len < 4 || buf[0] != 0xFF || buf[1] != 0xD8)
+        return false;
+    int components = 0, maxH = 1, maxV = 1, minV = 4;
+    bool hasFrame = false;
+    layout.restartInterval = 0;
+    size_t i = 2;
+    while (i + 4 <= len) {
+        if (buf[i] != 0xFF)
+            return false;
+        unsigned char marker = buf[i + 1];
+        if (marker == 0xFF) {   // 填充字节
+            i++;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            i += 2;
+            continue;
+        }
+        size_t seg = ((size_t)buf[i + 2] << 8) | buf[i + 3];
+        if (seg < 2 || i + 2 + seg > len)
+            return false;
+        const unsigned char *p = buf + i + 4;
+        if (marker == 0xC0 || marker == 0xC1) {
+            if (seg < 8)
+                return false;
+            layout.sofHeightOffset = i + 5;
+            layout.height = (p[1] << 8) | p[2];
+            layout.width = (p[3] << 8) | p[4];
+            components = p[5];
+            if (layout.height == 0 || components < 1 || seg < (size_t)(8 + components * 3))
+                return false;
+            for (int c = 0; c < components; c++) {
+                int h = p[6 + c * 3 + 1] >> 4, v = p[6 + c * 3 + 1] & 15;
+                if (h > maxH) maxH = h;
+                if (v > maxV) maxV = v;
+                if (v < minV) minV = v;
+            }
+            layout.verticalSubsampling = components > 1 && minV < maxV;
+            // 单通道图片不交错, MCU 固定为 8x8
+            layout.mcuWidth = components == 1 ? 8 : 8 * maxH;
+            layout.mcuHeight = components == 1 ? 8 : 8 * maxV;
+            hasFrame = true;
+        }else if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            return false;   // progressive / 无损 / 算术编码
+        }else if (marker == 0xDD) {
+            layout.restartInterval = (p[0] << 8) | p[1];
+        }else if (marker == 0xDA) {
+            if (!hasFrame || p[0] != components)
+                return false;
+            layout.scanStart = i + 2 + seg;
+            return true;
+        }
+        i += 2 + seg;
+    }
+    return false;
+}
+
+// 按 restart 边界切条带并行解码, 不满足条件时返回 false 由调用者整体解码
+static bool decodeJpegStrips(const unsigned char *buf, size_t len, const ImageInfo &info, bool flip, unsigned char *dst, int threads){
+    JpegLayout layout;
+    if (threads <= 1 || (long)info.width * info.height < PARALLEL_MIN_PIXELS)
+        return false;
+    if (!parseJpeg(buf, len, layout) || layout.restartInterval == 0)
+        return false;
+
+    // 找出所有 RSTn 标记, 把扫描数据切成 restart 区间
+    vector<size_t> segBegin(1, layout.scanStart), segEnd;
+    size_t scanEnd = 0;
+    for (size_t j = layout.scanStart; j + 1 < len;) {
+        if (buf[j] != 0xFF) {
+            j++;
+            continue;
+        }
+        unsigned char next = buf[j + 1];
+        if (next == 0x00) {
+            j += 2;
+        }else if (next == 0xFF) {
+            j++;
+        }else if (next >= 0xD0 && next <= 0xD7) {
+            segEnd.push_back(j);
+            segBegin.push_back(j + 2);
+            j += 2;
+        }else{
+            scanEnd = j;
+            break;
+        }
+    }
+    if (scanEnd == 0)
+        return false;
+    segEnd.push_back(scanEnd);
+
+    long mcusPerRow = (layout.width + layout.mcuWidth - 1) / layout.mcuWidth;
+    long mcuRows = (layout.height + layout.mcuHeight - 1) / layout.mcuHeight;
+    long interval = layout.restartInterval;
+    if ((long)segBegin.size() != (mcusPerRow * mcuRows + interval - 1) / interval)
+        return false;
+
+    // 条带只能从 MCU 行首的 restart 区间开始
+    vector<size_t> aligned;
+    for (size_t k = 0; k < segBegin.size(); k++) {
+        if ((long)k * interval % mcusPerRow == 0)
+            aligned.push_back(k);
+    }
+    aligned.push_back(segBegin.size());
+    vector<size_t> stripSeg(1, 0);
+    for (size_t a = 1; a + 1 < aligned.size() && (long)stripSeg.size() < threads; a++) {
+        long row = (long)aligned[a] * interval / mcusPerRow;
+        if (row >= mcuRows * (long)stripSeg.size() / threads)
+            stripSeg.push_back(aligned[a]);
+    }
+    if (stripSeg.size() < 2)
+        return false;
+    stripSeg.push_back(segBegin.size());
+
+    size_t strips = stripSeg.size() - 1;
+    vector<char> failed(strips, 0);
+    stbi_set_flip_vertically_on_load(false);
+    WorkerPool::shared().run((int)strips, [&](int strip){
+        size_t s = strip;
+        // 色度纵向下采样时, 边界行的插值需要相邻 MCU 行. 每条带多解码到下一个对齐的 restart 区间,
+        // 并把边界处的第一行交给上一条带写入, 保证结果与整体解码逐字节一致
+        size_t first = stripSeg[s], last = stripSeg[s + 1];
+        if (layout.verticalSubsampling && last < segBegin.size())
+            last = *upper_bound(aligned.begin(), aligned.end(), last);
+        long rowBegin = (long)first * interval / mcusPerRow;
+        long rowEnd = last < segBegin.size() ? (long)last * interval / mcusPerRow : mcuRows;
+        int y0 = (int)(rowBegin * layout.mcuHeight);
+        int stripHeight = (int)min((long)layout.height, rowEnd * layout.mcuHeight) - y0;
+        int overlap = layout.verticalSubsampling ? 1 : 0;
+        int copyBegin = s > 0 ? overlap : 0;
+        int copyEnd = s + 1 < strips ? (int)((long)stripSeg[s + 1] * interval / mcusPerRow * layout.mcuHeight) - y0 + overlap : stripHeight;
+
+        // 复制文件头并改写高度, 再拼上本条带的扫描数据(RST 标记从0重新编号)
+        vector<unsigned char> stream(buf, buf + layout.scanStart);
+        stream[layout.sofHeightOffset] = (unsigned char)(stripHeight >> 8);
+        stream[layout.sofHeightOffset + 1] = (unsigned char)(stripHeight & 0xFF);
+        for (size_t k = first; k < last; k++) {
+            if (k != first) {
+                stream.push_back(0xFF);
+                stream.push_back((unsigned char)(0xD0 + (k - first - 1) % 8));
+            }
+            stream.insert(stream.end(), buf + segBegin[k], buf + segEnd[k]);
+        }
+        stream.push_back(0xFF);
+        stream.push_back(0xD9);
+
+        int w, h, c;
+        unsigned char *pixels = stbi_load_from_memory(&stream[0], (int)stream.size(), &w, &h, &c, info.channels);
+        if (!pixels || w != info.width || h != stripHeight) {
+            failed[s] = 1;
+        }else{
+            size_t stride = (size_t)w * info.channels;
+            copyRows(pixels + copyBegin * stride, y0 + copyBegin, copyEnd - copyBegin, info.width, info.height, info.channels, flip, dst);
+        }
+        stbi_image_free(pixels);
+    });
+    for (size_t s = 0; s < strips; s++) {
+        if (failed[s])
+            return false;
+    }
+    return true;
+}
+
+bool getImageInfo(const unsigned char *buffer, int length, int desiredChannels, ImageInfo &info){
+    int comp;
+    if (!stbi_info_from_memory(buffer, length, &info.width, &info.height, &comp))
+        return false;
+    info.channels = desiredChannels != 0 ? desiredChannels : comp;
+    return true;
+}
+
+bool decodeImageInto(const unsigned char *buffer, int length, int desiredChannels, bool flip, unsigned char *dst, int threads){
+    ImageInfo info;
+    if (!getImageInfo(buffer, length, desiredChannels, info))
+        return false;
+    threads = workerThreadCount(threads);
+
+    if (decodeJpegStrips(buffer, (size_t)length, info, flip, dst, threads))
+        return true;
+
+    // 整体解码, 之后并行翻转拷贝到目标缓冲区
+    int w, h, c;
+    stbi_set_flip_vertically_on_load(false);
+    unsigned char *pixels = stbi_load_from_memory(buffer, length, &w, &h, &c, info.channels);
+    if (!pixels)
+        return false;
+    if ((long)w * h < PARALLEL_MIN_PIXELS)
+        threads = 1;
+    size_t stride = (size_t)w * info.channels;
+    parallelRows(h, threads, [&](int begin, int end){
+        copyRows(pixels + begin * stride, begin, end - begin, w, h, info.channels, flip, dst);
+    });
+    stbi_image_free(pixels);
+    return true;
+}
@@ -0,0 +1,32 @@
+//
+//  imageDecoder.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/15.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include <iostream>
+#include <string>
+
+// 多线程图片解码.
+// 带 restart 标记(DRI)的 baseline JPEG 在 MCU 行对齐的 restart 边界处切成若干条带, 每条带在独立线程中解码;
+// 其他格式(PNG、progressive JPEG 等)整体解码, 之后的翻转、拷贝按行并行.
+// 结果直接写入调用者提供的缓冲区(例如映射后的PBO), 行与行之间紧密排列.
+
+struct ImageInfo{
+    int width;
+    int height;
+    int channels;   // 写入目标缓冲区的通道数
+};
+
+// 只读取图片头部信息, desiredChannels 为0时使用文件本身的通道数
+bool getImageInfo(const unsigned char *buffer, int length, int desiredChannels, ImageInfo &info);
+
+// 解码到 dst(大小至少为 width*height*channels), threads 为0时使用全部硬件线程
+bool decodeImageInto(const unsigned char *buffer, int length, int desiredChannels, bool flip, unsigned char *dst, int threads = 0);
+
+#endif /* imageDecoder_hpp */
@@ -7,44 +7,91 @@
 //
 
 #include "texture.hpp"
+#include "imageDecoder.hpp"
+#include "../vfs/assetPack.hpp"
 #include "../stb/stb.cpp"
 
 using namespace std;
 
-unsigned int loadTexture(char *file){
-    
+// 根据后缀决定 stbi 解码的通道数
+static int requestedChannels(const string &suffix){
+    if (suffix.compare(".jpg") == 0 || suffix.compare(".JPG") == 0) {
+        cout << "Texture image is jpg" << endl;
+        return 0;
+    }else if(suffix.compare(".png") == 0 || suffix.compare(".PNG") == 0){
+        cout << "Texture image is png" << endl;
+        return STBI_rgb;
+    }
+    return STBI_rgb_alpha;
+}
+
+static string fileSuffix(const char *file){
     string filename = file;
     unsigned long suffix_pos = filename.find_last_of(".");
-    string suffix = filename.substr(suffix_pos);
+    if (suffix_pos == string::npos)
+        return "";
+    return filename.substr(suffix_pos);
+}
+
+// 生成纹理对象并上传图片. 解码结果直接写入映射后的PBO, 省去一次CPU端的拷贝
+// 解码失败时仍返回(空的)纹理对象, loaded 置为 false
+static unsigned int createTexture(const unsigned char *buffer, int length, int channels, bool *loaded){
     // 箱子的纹理
     unsigned int texture_cube;
     glGenTextures(1, &texture_cube);
     glBindTexture(GL_TEXTURE_2D, texture_cube);
-    stbi_set_flip_vertically_on_load(true);
 
     // 为当前绑定的纹理对象设置环绕、过滤方式
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    
-    int t_width, t_height, nrChannels;
-    unsigned char *data= NULL;
-    if (suffix.compare(".jpg") == 0 || suffix.compare(".JPG") == 0) {
-        cout << "Texture image is jpg" << endl;
-        data = stbi_load(file, &t_width, &t_height, &nrChannels, NULL);
-    }else if(suffix.compare(".png") == 0 || suffix.compare(".PNG") == 0){
-        cout << "Texture image is png" << endl;
-        data = stbi_load(file, &t_width, &t_height, &nrChannels, STBI_rgb);
-    }else{
-        data = stbi_load(file, &t_width, &t_height, &nrChannels, STBI_rgb_alpha);
+
+    if (loaded != NULL)
+        *loaded = false;
+    ImageInfo info;
+    if (buffer == NULL || !getImageInfo(buffer, length, channels, info)) {
+        std::cout << "Failed to load texture"  << endl;
+        return texture_cube;
     }
-    if (data) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, t_width, t_height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+    GLenum format = info.channels == 4 ? GL_RGBA : (info.channels == 1 ? GL_RED : GL_RGB);
+
+    GLuint pbo;
+    glGenBuffers(1, &pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)info.width * info.height * info.channels, NULL, GL_STREAM_DRAW);
+    unsigned char *pixels = (unsigned char *)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    bool decoded = pixels != NULL && decodeImageInto(buffer, length, info.channels, true, pixels);
+    if (pixels != NULL)
+        decoded = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE && decoded;
+
+    if (decoded) {
+        GLint alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, info.width, info.height, 0, format, GL_UNSIGNED_BYTE, (void*)0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        // 灰度图按单通道上传省显存, 采样时把 R 复制到 G、B, 着色器里仍然是灰色而不是红色
+        if (format == GL_RED) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+        }
         glGenerateMipmap(GL_TEXTURE_2D);
     }else
         std::cout << "Failed to load texture"  << endl;
-    stbi_image_free(data);
-    
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &pbo);
+    if (loaded != NULL)
+        *loaded = decoded;
+
     return texture_cube;
 }
+
+unsigned int loadTexture(char *file){
+    AssetFile imageFile(file);
+    return loadTextureFromMemory(imageFile.data(), (int)imageFile.size(), file);
+}
+
+unsigned int loadTextureFromMemory(const unsigned char *buffer, int length, const char *file, bool *loaded){
+    return createTexture(length > 0 ? buffer : NULL, length, requestedChannels(fileSuffix(file)), loaded);
+}
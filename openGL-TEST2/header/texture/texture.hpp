@@ -17,5 +17,8 @@
 
 // 加载纹理图片并返回纹理id
 unsigned int loadTexture(char *);
+// 从内存中的图片文件数据加载纹理, file 仅用于根据后缀判断格式.
+// 解码失败时同样返回一个空纹理(可以绑定), loaded 不为空时写入是否成功
+unsigned int loadTextureFromMemory(const unsigned char *buffer, int length, const char *file, bool *loaded = NULL);
 
 #endif /* texture_hpp */
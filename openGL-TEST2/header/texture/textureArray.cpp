@@ -0,0 +1,123 @@
+//
+//  textureArray.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/12.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "textureArray.hpp"
+#include "imageDecoder.hpp"
+#include "../vfs/assetPack.hpp"
+#include "../stb/stb_image.h"
+
+#include <vector>
+
+using namespace std;
+
+// 双线性缩放RGB图片到目标尺寸
+static void resampleRGB(const unsigned char *src, int src_w, int src_h, unsigned char *dst, int dst_w, int dst_h){
+    float x_ratio = dst_w > 1 ? (float)(src_w - 1) / (dst_w - 1) : 0.0f;
+    float y_ratio = dst_h > 1 ? (float)(src_h - 1) / (dst_h - 1) : 0.0f;
+    for (int y = 0; y < dst_h; y++) {
+        float fy = y * y_ratio;
+        int y0 = (int)fy;
+        int y1 = y0 + 1 < src_h ? y0 + 1 : y0;
+        float ty = fy - y0;
+        for (int x = 0; x < dst_w; x++) {
+            float fx = x * x_ratio;
+            int x0 = (int)fx;
+            int x1 = x0 + 1 < src_w ? x0 + 1 : x0;
+            float tx = fx - x0;
+            for (int c = 0; c < 3; c++) {
+                float p00 = src[(y0 * src_w + x0) * 3 + c];
+                float p01 = src[(y0 * src_w + x1) * 3 + c];
+                float p10 = src[(y1 * src_w + x0) * 3 + c];
+                float p11 = src[(y1 * src_w + x1) * 3 + c];
+                float top = p00 + (p01 - p00) * tx;
+                float bottom = p10 + (p11 - p10) * tx;
+                dst[(y * dst_w + x) * 3 + c] = (unsigned char)(top + (bottom - top) * ty + 0.5f);
+            }
+        }
+    }
+}
+
+TextureArray::TextureArray() : ID(0), width(0), height(0), maxLayers(0), usedLayers(0){
+}
+
+void TextureArray::create(int width, int height, int layers){
+    this->width = width;
+    this->height = height;
+    this->maxLayers = layers;
+    this->usedLayers = 0;
+
+    glGenTextures(1, &ID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, width, height, layers, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+
+    // 与 loadTexture 保持一致的环绕、过滤方式
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+int TextureArray::addLayer(char *file){
+    if (ID == 0 || usedLayers >= maxLayers) {
+        cout << "ERROR::TEXTURE_ARRAY: No free layer for " << file << endl;
+        return -1;
+    }
+
+    AssetFile imageFile(file);
+    const unsigned char *buffer = imageFile.data();
+    int length = (int)imageFile.size();
+
+    ImageInfo info;
+    vector<unsigned char> data;
+    if (length == 0 || !getImageInfo(buffer, length, STBI_rgb, info)) {
+        cout << "Failed to load texture" << endl;
+        return -1;
+    }
+    data.resize((size_t)info.width * info.height * 3);
+    if (!decodeImageInto(buffer, length, STBI_rgb, true, &data[0])) {
+        cout << "Failed to load texture" << endl;
+        return -1;
+    }
+
+    vector<unsigned char> resized;
+    const unsigned char *pixels = &data[0];
+    if (info.width != width || info.height != height) {
+        resized.resize((size_t)width * height * 3);
+        resampleRGB(&data[0], info.width, info.height, &resized[0], width, height);
+        pixels = &resized[0];
+    }
+
+    GLint alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, usedLayers, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+
+    return usedLayers++;
+}
+
+void TextureArray::generateMipmap(){
+    glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void TextureArray::bind(GLenum unit){
+    glActiveTexture(unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+}
+
+void TextureArray::release(){
+    if (ID != 0)
+        glDeleteTextures(1, &ID);
+    ID = 0;
+    usedLayers = 0;
+}
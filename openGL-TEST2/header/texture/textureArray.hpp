@@ -0,0 +1,44 @@
+//
+//  textureArray.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/12.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <iostream>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <string>
+
+// 将多张材质纹理打包进同一个 GL_TEXTURE_2D_ARRAY, 每个物体通过层索引取用。
+// 这样整个不透明物体的 pass 只需要绑定一次纹理。
+class TextureArray{
+public:
+    GLuint ID;
+
+    TextureArray();
+
+    // 分配 width x height x layers 的纹理数组存储(需要在GL上下文创建之后调用)
+    void create(int width, int height, int layers);
+    // 加载图片到下一个空闲的层, 尺寸不一致时会先缩放到数组的尺寸. 返回层索引, 失败返回-1
+    int addLayer(char *file);
+    // 所有层加载完之后生成 mipmap
+    void generateMipmap();
+    // 绑定到指定的纹理单元
+    void bind(GLenum unit);
+    void release();
+
+    int layerCount() const { return usedLayers; }
+
+private:
+    int width;
+    int height;
+    int maxLayers;
+    int usedLayers;
+};
+
+#endif /* textureArray_hpp */
@@ -0,0 +1,109 @@
+//
+//  textureRegistry.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/14.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "textureRegistry.hpp"
+#include "texture.hpp"
+#include "../vfs/assetPack.hpp"
+#include "../util/hash.hpp"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+
+TextureRegistry::TextureRegistry(){
+}
+
+unsigned int TextureRegistry::acquire(char *file){
+    string path = canonicalPath(file);
+    map<string, unsigned int>::iterator it = byPath.find(path);
+    if (it != byPath.end()) {
+        entries[it->second].refs++;
+        return it->second;
+    }
+
+    // 路径没有命中时读取文件内容, 内容相同的图片(不同路径)共用同一个纹理
+    AssetFile imageFile(file);
+    if (!imageFile.valid()) {
+        cout << "ERROR::TEXTURE_REGISTRY: Failed to open " << file << endl;
+        return 0;
+    }
+    uint64_t hash = fnv1a64(imageFile.data(), imageFile.size());
+
+    map<uint64_t, unsigned int>::iterator hit = byHash.find(hash);
+    if (hit != byHash.end() && sameContent(entries[hit->second], imageFile.data(), imageFile.size())) {
+        byPath[path] = hit->second;
+        entries[hit->second].refs++;
+        return hit->second;
+    }
+
+    bool loaded = false;
+    unsigned int textureID = loadTextureFromMemory(imageFile.data(), (int)imageFile.size(), file, &loaded);
+    if (!loaded) {
+        glDeleteTextures(1, &textureID);
+        return 0;
+    }
+    Entry entry = {1, hash, imageFile.size(), file};
+    entries[textureID] = entry;
+    // 哈希碰撞时保留先登记的纹理, 这张只按路径查找
+    if (hit == byHash.end())
+        byHash[hash] = textureID;
+    byPath[path] = textureID;
+    return textureID;
+}
+
+void TextureRegistry::release(unsigned int textureID){
+    map<unsigned int, Entry>::iterator it = entries.find(textureID);
+    if (it == entries.end())
+        return;
+    if (--it->second.refs > 0)
+        return;
+
+    map<uint64_t, unsigned int>::iterator hit = byHash.find(it->second.hash);
+    if (hit != byHash.end() && hit->second == textureID)
+        byHash.erase(hit);
+    for (map<string, unsigned int>::iterator p = byPath.begin(); p != byPath.end();) {
+        if (p->second == textureID)
+            byPath.erase(p++);
+        else
+            ++p;
+    }
+    entries.erase(it);
+    glDeleteTextures(1, &textureID);
+}
+
+void TextureRegistry::clear(){
+    for (map<unsigned int, Entry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+        unsigned int textureID = it->first;
+        glDeleteTextures(1, &textureID);
+    }
+    entries.clear();
+    byHash.clear();
+    byPath.clear();
+}
+
+int TextureRegistry::refCount(unsigned int textureID) const{
+    map<unsigned int, Entry>::const_iterator it = entries.find(textureID);
+    return it == entries.end() ? 0 : it->second.refs;
+}
+
+string TextureRegistry::canonicalPath(const char *file){
+    char resolved[PATH_MAX];
+    if (realpath(file, resolved) == NULL)
+        return file;
+    return resolved;
+}
+
+bool TextureRegistry::sameContent(const Entry &entry, const unsigned char *data, size_t size){
+    if (entry.size != size)
+        return false;
+    AssetFile imageFile(entry.file.c_str());
+    return imageFile.valid() && imageFile.size() == size && memcmp(imageFile.data(), data, size) == 0;
+}
+
@@ -0,0 +1,52 @@
+//
+//  textureRegistry.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/14.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <stdint.h>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+// 纹理注册表: 以规范化路径和文件内容哈希去重, 同一张图片只解码、上传一次.
+// 哈希命中时再比较文件大小和内容, 哈希碰撞的两张图片不会共用纹理; 解码失败的图片不登记.
+// acquire/release 维护引用计数, 计数归零时立即删除GL纹理.
+class TextureRegistry{
+public:
+    TextureRegistry();
+    ~TextureRegistry() {};
+
+    // 获取(必要时加载)纹理, 引用计数+1, 失败返回0
+    unsigned int acquire(char *file);
+    // 引用计数-1, 归零时释放GL纹理
+    void release(unsigned int textureID);
+    // 释放所有纹理(需要在GL上下文销毁之前调用)
+    void clear();
+
+    int refCount(unsigned int textureID) const;
+    size_t size() const { return entries.size(); }
+
+private:
+    struct Entry{
+        int refs;
+        uint64_t hash;
+        size_t size;        // 文件字节数
+        std::string file;   // 第一次加载时的文件名, 哈希命中时重新读取比较内容
+    };
+    std::map<std::string, unsigned int> byPath;
+    std::map<uint64_t, unsigned int> byHash;
+    std::map<unsigned int, Entry> entries;
+
+    static std::string canonicalPath(const char *file);
+    static bool sameContent(const Entry &entry, const unsigned char *data, size_t size);
+};
+
+#endif /* textureRegistry_hpp */
@@ -0,0 +1,140 @@
+//
+//  flatHashMap.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/20.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef FLAT_HASH_MAP_H
+#define FLAT_HASH_MAP_H
+
+#include <vector>
+#include <stdint.h>
+
+// 以 uint64_t 为键的开放寻址哈希表(线性探测), 所有元素存放在一块连续内存里.
+// 插入可能触发扩容, 之前 find 得到的指针随之失效.
+template <typename T>
+class FlatHashMap{
+public:
+    FlatHashMap() : count(0), used(0), shift(64) {}
+
+    T *find(uint64_t key){
+        size_t i = indexOf(key);
+        return i == slots.size() ? NULL : &slots[i].value;
+    }
+
+    // 插入或覆盖, 返回表内元素的引用
+    T &insert(uint64_t key, const T &value){
+        T *existing = find(key);
+        if (existing != NULL) {
+            *existing = value;
+            return *existing;
+        }
+        // 装载因子(含墓碑)超过 0.7 时扩容或重建
+        if ((used + 1) * 10 > slots.size() * 7)
+            rehash(count * 2 + 16);
+        size_t mask = slots.size() - 1;
+        size_t i = bucket(key);
+        while (slots[i].state == FULL)
+            i = (i + 1) & mask;
+        if (slots[i].state == EMPTY)
+            used++;
+        slots[i].state = FULL;
+        slots[i].key = key;
+        slots[i].value = value;
+        count++;
+        return slots[i].value;
+    }
+
+    bool erase(uint64_t key){
+        size_t i = indexOf(key);
+        if (i == slots.size())
+            return false;
+        slots[i].state = DELETED;
+        count--;
+        return true;
+    }
+
+    // 删除所有满足 pred(key, value) 的元素
+    template <typename Pred>
+    size_t eraseIf(Pred pred){
+        size_t erased = 0;
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (slots[i].state == FULL && pred(slots[i].key, slots[i].value)) {
+                slots[i].state = DELETED;
+                erased++;
+            }
+        }
+        count -= erased;
+        return erased;
+    }
+
+    // 遍历所有元素, f(key, value)
+    template <typename Func>
+    void forEach(Func f) const{
+        for (size_t i = 0; i < slots.size(); i++)
+            if (slots[i].state == FULL)
+                f(slots[i].key, slots[i].value);
+    }
+
+    void clear(){
+        slots.clear();
+        count = used = 0;
+        shift = 64;
+    }
+
+    size_t size() const { return count; }
+
+private:
+    enum { EMPTY = 0, FULL = 1, DELETED = 2 };
+    struct Slot{
+        uint64_t key;
+        unsigned char state;
+        T value;
+    };
+    std::vector<Slot> slots;
+    size_t count;   // 有效元素数
+    size_t used;    // 有效元素 + 墓碑
+    int shift;
+
+    // Fibonacci 哈希, 取高位作为桶号
+    size_t bucket(uint64_t key) const{
+        return (size_t)((key * 11400714819323198485ULL) >> shift);
+    }
+
+    // 返回键所在的槽位, 不存在时返回 slots.size()
+    size_t indexOf(uint64_t key) const{
+        if (slots.empty())
+            return 0;
+        size_t mask = slots.size() - 1;
+        for (size_t i = bucket(key);; i = (i + 1) & mask) {
+            const Slot &slot = slots[i];
+            if (slot.state == EMPTY)
+                return slots.size();
+            if (slot.state == FULL && slot.key == key)
+                return i;
+        }
+    }
+
+    void rehash(size_t minCapacity){
+        size_t capacity = 16;
+        int bits = 4;
+        while (capacity * 7 < minCapacity * 10) {
+            capacity *= 2;
+            bits++;
+        }
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.resize(capacity);
+        for (size_t i = 0; i < capacity; i++)
+            slots[i].state = EMPTY;
+        shift = 64 - bits;
+        count = used = 0;
+        for (size_t i = 0; i < old.size(); i++)
+            if (old[i].state == FULL)
+                insert(old[i].key, old[i].value);
+    }
+};
+
+#endif /* flatHashMap_hpp */
@@ -0,0 +1,26 @@
+//
+//  hash.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/4/6.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// FNV-1a 64位. 资源包和字体缓存文件里存的就是这个哈希, 改算法要同时改格式版本
+inline uint64_t fnv1a64(const void *data, size_t length){
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+#endif /* hash_hpp */
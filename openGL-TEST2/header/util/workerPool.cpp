@@ -0,0 +1,88 @@
+//
+//  workerPool.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/4/6.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "workerPool.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+int workerThreadCount(int threads){
+    if (threads > 0)
+        return threads;
+    int hw = (int)thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+WorkerPool &WorkerPool::shared(){
+    static WorkerPool pool;
+    return pool;
+}
+
+WorkerPool::WorkerPool() : stopping(false) {}
+
+WorkerPool::~WorkerPool(){
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+}
+
+void WorkerPool::run(int count, const function<void(int)> &job){
+    if (count <= 1) {
+        for (int i = 0; i < count; i++)
+            job(i);
+        return;
+    }
+    // batch 在栈上, 返回前所有任务都已完成, 工作线程不会再碰它
+    Batch batch = {&job, 0, count, count};
+    unique_lock<mutex> guard(lock);
+    int wanted = min(count, workerThreadCount(0)) - 1;
+    while ((int)threads.size() < wanted)
+        threads.push_back(thread(&WorkerPool::work, this));
+    pending.push_back(&batch);
+    wake.notify_all();
+    while (batch.next < batch.total)
+        execute(&batch, guard);
+    done.wait(guard, [&batch](){ return batch.remaining == 0; });
+}
+
+// 领取 batch 的下一个任务并执行, 进入和返回时持有 lock
+void WorkerPool::execute(Batch *batch, unique_lock<mutex> &guard){
+    int i = batch->next++;
+    if (batch->next == batch->total)
+        pending.erase(find(pending.begin(), pending.end(), batch));
+    guard.unlock();
+    (*batch->job)(i);
+    guard.lock();
+    if (--batch->remaining == 0)
+        done.notify_all();
+}
+
+void WorkerPool::work(){
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [this](){ return stopping || !pending.empty(); });
+        if (stopping)
+            return;
+        execute(pending.front(), guard);
+    }
+}
+
+void parallelRows(int rows, int parts, const function<void(int, int)> &job){
+    if (parts <= 1 || rows < parts) {
+        job(0, rows);
+        return;
+    }
+    WorkerPool::shared().run(parts, [&](int t){
+        job((int)((long long)rows * t / parts), (int)((long long)rows * (t + 1) / parts));
+    });
+}
@@ -0,0 +1,55 @@
+//
+//  workerPool.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/4/6.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// 常驻的工作线程: 第一次需要并行时创建, 之后图片解码、球体生成、模型解析等都复用, 不再每次创建、join 一批线程.
+// 提交任务的线程也领取自己那一批的任务; 多个线程可以同时提交(如后台的模型解析和主线程的图片解码), 互不等待对方的批次.
+class WorkerPool{
+public:
+    static WorkerPool &shared();
+
+    // 执行 job(0) ~ job(count-1), 全部完成后返回
+    void run(int count, const std::function<void(int)> &job);
+
+    ~WorkerPool();
+
+private:
+    struct Batch{
+        const std::function<void(int)> *job;
+        int next, total, remaining;
+    };
+
+    std::mutex lock;
+    std::condition_variable wake, done;
+    std::vector<std::thread> threads;
+    std::vector<Batch *> pending;   // 还有任务没被领取的批次
+    bool stopping;
+
+    WorkerPool();
+    void execute(Batch *batch, std::unique_lock<std::mutex> &guard);
+    void work();
+
+    WorkerPool(const WorkerPool &);
+    WorkerPool &operator=(const WorkerPool &);
+};
+
+// threads 为0时取硬件线程数
+int workerThreadCount(int threads);
+
+// 把 [0, rows) 按连续区间分成 parts 段, 在 WorkerPool 上执行 job(first, last), 区间之间互不重叠
+void parallelRows(int rows, int parts, const std::function<void(int first, int last)> &job);
+
+#endif /* workerPool_hpp */
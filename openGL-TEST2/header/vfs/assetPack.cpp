@@ -0,0 +1,137 @@
+//
+//  assetPack.cpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/16.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#include "assetPack.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static AssetPack mountedPack;
+
+AssetPack::AssetPack() : base(NULL), length(0), entries(NULL), names(NULL), count(0){
+}
+
+AssetPack::~AssetPack(){
+    close();
+}
+
+bool AssetPack::open(const char *path){
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(AssetPackHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void *mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+    // 冷启动时让内核提前把整个包读进来, 减少随机寻道
+    madvise(mapped, (size_t)st.st_size, MADV_WILLNEED);
+
+    base = (const unsigned char *)mapped;
+    length = (size_t)st.st_size;
+
+    const AssetPackHeader *header = (const AssetPackHeader *)base;
+    // 偏移和大小来自文件, 先减后比较, 避免相加或相乘溢出后绕过检查
+    if (memcmp(header->magic, ASSET_PACK_MAGIC, 4) != 0 || header->version != ASSET_PACK_VERSION ||
+        header->indexOffset > length || header->count > (length - header->indexOffset) / sizeof(AssetPackEntry) ||
+        header->namesOffset > length) {
+        cout << "ERROR::ASSET_PACK: Invalid asset pack " << path << endl;
+        close();
+        return false;
+    }
+    entries = (const AssetPackEntry *)(base + header->indexOffset);
+    names = (const char *)(base + header->namesOffset);
+    count = header->count;
+    size_t namesLength = length - header->namesOffset;
+    for (uint32_t i = 0; i < count; i++) {
+        const AssetPackEntry &entry = entries[i];
+        if (entry.offset > length || entry.size > length - entry.offset ||
+            entry.nameOffset > namesLength || entry.nameLength > namesLength - entry.nameOffset) {
+            cout << "ERROR::ASSET_PACK: Corrupted entry in " << path << endl;
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void AssetPack::close(){
+    if (base != NULL)
+        munmap((void *)base, length);
+    base = NULL;
+    length = 0;
+    entries = NULL;
+    names = NULL;
+    count = 0;
+}
+
+bool AssetPack::find(const char *name, AssetSpan &span) const{
+    if (base == NULL)
+        return false;
+    size_t nameLength = strlen(name);
+    uint64_t hash = fnv1a64(name, nameLength);
+
+    // 索引按 hash 排序, 二分查找后再比较文件名排除冲突
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (entries[mid].hash < hash)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (uint32_t i = lo; i < count && entries[i].hash == hash; i++) {
+        const AssetPackEntry &entry = entries[i];
+        if (entry.nameLength == nameLength && memcmp(names + entry.nameOffset, name, nameLength) == 0) {
+            span.data = base + entry.offset;
+            span.size = (size_t)entry.size;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AssetPack::mount(const char *path){
+    return mountedPack.open(path);
+}
+
+void AssetPack::unmount(){
+    mountedPack.close();
+}
+
+const AssetPack &AssetPack::mounted(){
+    return mountedPack;
+}
+
+AssetFile::AssetFile(const char *path){
+    span.data = NULL;
+    span.size = 0;
+    if (mountedPack.find(path, span))
+        return;
+
+    ifstream file(path, ios::in | ios::binary);
+    if (!file)
+        return;
+    stringstream stream;
+    stream << file.rdbuf();
+    storage = stream.str();
+    span.data = (const unsigned char *)storage.data();
+    span.size = storage.size();
+}
@@ -0,0 +1,92 @@
+//
+//  assetPack.hpp
+//  openGL-TEST2
+//
+//  Created by Lax Zhang on 2019/3/16.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <iostream>
+#include <string>
+#include <stdint.h>
+
+#include "../util/hash.hpp"
+
+// 资源包格式(由 assetPacker 生成):
+// [AssetPackHeader][AssetPackEntry x count, 按 hash 排序][文件名表][按 alignment 对齐的文件数据...]
+#define ASSET_PACK_MAGIC "APAK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_ALIGNMENT 64
+
+struct AssetPackHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t alignment;
+    uint64_t indexOffset;
+    uint64_t namesOffset;
+};
+
+struct AssetPackEntry{
+    uint64_t hash;          // 文件相对路径的 FNV-1a 哈希
+    uint64_t offset;
+    uint64_t size;
+    uint32_t nameOffset;    // 相对文件名表的偏移
+    uint32_t nameLength;
+};
+
+// 指向资源数据的只读区间(不拥有内存)
+struct AssetSpan{
+    const unsigned char *data;
+    size_t size;
+};
+
+// mmap 整个资源包, 按路径查找时直接返回映射内存中的区间, 不做拷贝
+class AssetPack{
+public:
+    AssetPack();
+    ~AssetPack();
+
+    bool open(const char *path);
+    void close();
+    bool isOpen() const { return base != NULL; }
+    // 按打包时的相对路径(如 "resources/images/wood.png")查找
+    bool find(const char *name, AssetSpan &span) const;
+
+    // 全局挂载的资源包, AssetFile 优先从这里读取
+    static bool mount(const char *path);
+    static void unmount();
+    static const AssetPack &mounted();
+
+private:
+    const unsigned char *base;
+    size_t length;
+    const AssetPackEntry *entries;
+    const char *names;
+    uint32_t count;
+
+    AssetPack(const AssetPack &);
+    AssetPack &operator=(const AssetPack &);
+};
+
+// 读取一个资源文件: 挂载了资源包且包含该文件时零拷贝返回映射内存, 否则读取磁盘文件
+class AssetFile{
+public:
+    explicit AssetFile(const char *path);
+
+    bool valid() const { return span.data != NULL; }
+    const unsigned char *data() const { return span.data; }
+    size_t size() const { return span.size; }
+
+private:
+    AssetSpan span;
+    std::string storage;
+
+    AssetFile(const AssetFile &);
+    AssetFile &operator=(const AssetFile &);
+};
+
+#endif /* assetPack_hpp */
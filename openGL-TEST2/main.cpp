@@ -15,11 +15,24 @@
 #include <math.h>
 
 #include "header/fonts/FontsManager.hpp"
+#include "header/fonts/textBatch.hpp"
+#include "header/fonts/textLayout.hpp"
+#include "header/fonts/instancedTextBatch.hpp"
+#include "header/fonts/textFormat.hpp"
 #include "header/texture/texture.hpp"
+#include "header/texture/textureArray.hpp"
+#include "header/texture/bindlessTable.hpp"
+#include "header/texture/textureRegistry.hpp"
 #include "header/shader/shader.hpp"
 #include "header/camera/camera.hpp"
 #include "vertices/vertices.hpp"
 #include "header/sphere/sphere.hpp"
+#include "header/sphere/sphereLOD.hpp"
+#include "header/mesh/meshCache.hpp"
+#include "header/mesh/vertexFormat.hpp"
+#include "header/mesh/geometryPool.hpp"
+#include "header/mesh/meshLoader.hpp"
+#include "header/vfs/assetPack.hpp"
 
 using namespace std;
 
@@ -34,9 +47,10 @@ void framebuffer_size_callback(GLFWwindow*, int, int);
 void processInput(GLFWwindow*);
 void mouseCallback(GLFWwindow*, double, double);
 void scrollCallback(GLFWwindow *, double, double);
-void renderScene(Shader &shader);
+void renderScene(Shader &shader, const glm::mat4 &viewProjection);
+void bindMaterial(GLuint textureID, int material);
 void renderLightSource(Shader &shader);
-void renderText(Shader &shader, string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color);
+void renderHUD(Shader &shader, Shader &instancedShader);
 
 // basic param
 const int window_width = 1280;
@@ -54,6 +68,18 @@ bool firstMouse = true;
 
 // font manage.
 FontsManager fontsManager;
+// 所有 HUD 文字合并成一次上传、每个图集页一次绘制
+TextBatch textBatch;
+// 不变的提示文字只排版上传一次
+TextLayout helpLayout;
+// HUD 中的数字: 只在显示的值变化时重新格式化到固定缓冲, 稳定状态下不分配堆内存
+TextBuffer fpsText, cameraText;
+NumberField fpsField(0), cameraXField(2), cameraYField(2), cameraZField(2);
+// 距离场字体: 同一份图集支持任意缩放和描边
+bool useSDFText = true;
+// 实例化文字: 每个字形只上传20字节, 四边形在顶点着色器中展开
+bool useInstancedText = true;
+InstancedTextBatch instancedBatch;
 
 // timing
 float initial_time, deltaTime =0.0f;
@@ -63,13 +89,39 @@ int frame = 0, frameCount = 0;
 // 光空间变换矩阵
 glm::mat4 lightSpaceMatrix;
 
-// 顶点/缓冲/索引
-GLuint Fl_VAO, Fl_VBO, cube_VAO, cube_VBO, lighterVAO, sphereVAO, sphereVBO, sphereEBO, TextVAO, Text_VBO;
+// 静态网格(地板/立方体/球体各级)共用一个VAO/VBO/EBO, 一个 pass 只绑定一次
+GeometryPool staticGeometry;
+GeometryRange floorRange, cubeRange;
 GLuint depthMap, depthMapFBO;
-vector<GLuint> sphere_indices;
-
-// 纹理ID
+// 生成的网格只构建一次, 并缓存到磁盘, 之后启动直接 mmap
+MeshCache meshCache;
+// 球体 LOD 链: 按屏幕上的大小选择分段数, 每个球体记住上一帧的级别
+// 默认用测地线球(细分 0~5 次), 同样的轮廓误差三角形少得多; 关掉时用 UV 球
+bool useIcosphere = true;
+const int SPHERE_LOD_SEGMENTS[] = {8, 16, 32, 64, 128};
+const int ICOSPHERE_LOD_SUBDIVISIONS[] = {0, 1, 2, 3, 4, 5};
+// 三角形带 + 图元重启: 索引约为三角形列表的一半以下, 但顶点缓存命中率较低(ACMR 约 1.0 对 0.7)
+bool useSphereStrips = false;
+SphereLOD sphereLOD;
+int sunLOD = -1, moonLOD = -1;
+// 外部模型(OBJ/glb)在后台线程解析, 每帧上传一部分; 尺寸未知, 位置用 float, 索引用 32 位
+GeometryPool modelGeometry;
+MeshLoader modelLoader;
+
+// 纹理ID(由 textureRegistry 统一管理, 同一文件只加载一次)
 GLuint floorTextureID, boxTextureID, sunTextureID, moonTextureID;
+TextureRegistry textureRegistry;
+
+// 材质纹理数组: 地板、箱子、月球打包进同一个 GL_TEXTURE_2D_ARRAY, 不透明物体只绑定一次
+bool useTextureArray = true;
+const int MATERIAL_SIZE = 1024, MATERIAL_LAYERS = 3;
+TextureArray materialArray;
+// bindless 纹理: 驱动支持 ARB_bindless_texture 时优先使用, 否则退回到纹理数组
+bool useBindless = true;
+const size_t TEXTURE_BUDGET = 256 * 1024 * 1024; // 常驻纹理的显存预算(字节)
+BindlessTextureTable materialTable;
+// 材质索引(纹理数组的层, 或 bindless 句柄表的下标)
+int floorMaterial, boxMaterial, moonMaterial;
 
 // 光源位置
 glm::vec3 lightPos = glm::vec3(1.0, 1.0f, 1.0f);
@@ -80,9 +132,21 @@ char texture_box[255] = "resources/images/container2.png";
 char texture_sun[255] = "resources/images/2k_sun.jpg";
 char texture_moon[255] = "resources/images/2k_moon.jpg";
 char font_roman[255] = "resources/fonts/Times New Roman.ttf";
+// 字形缓存(图集+度量), 命中时启动不需要 FreeType
+char font_cache[255] = "fonts.cache";
+// 资源包(由 assetPacker 生成), 存在时所有资源都从这里 mmap 读取
+char asset_pack[255] = "assets.pack";
+// 网格缓存目录
+char mesh_cache[255] = "meshes.cache";
+// 模型文件(.obj 或 .glb), 为空时不加载
+char model_file[255] = "";
 
 int main(int argc, const char * argv[]) {
     
+    // 0. 挂载资源包, 不存在时直接读取各个资源文件
+    if (AssetPack::mount(asset_pack))
+        cout << "Mounted asset pack " << asset_pack << endl;
+
     // 1. 初始化
     if(init() == -1){
         glfwTerminate();
@@ -91,8 +155,19 @@ int main(int argc, const char * argv[]) {
     // 2. 编译着色器
     Shader simpleDepthShader("shaders/shader_depth.vs", "shaders/shader_depth.fs");
     Shader shadowShader("shaders/shader_shadow.vs", "shaders/shader_shadow.fs");
+    Shader shadowArrayShader("shaders/shader_shadow_array.vs", "shaders/shader_shadow_array.fs");
+    Shader shadowBindlessShader;
+    if (useBindless) {
+        shadowBindlessShader = Shader("shaders/shader_shadow_bindless.vs", "shaders/shader_shadow_bindless.fs");
+        // 着色器里不写 binding(需要 420pack), 链接后再指定句柄表的绑定点, 与 materialTable.bind(0) 对应
+        GLuint block = glGetProgramResourceIndex(shadowBindlessShader.ID, GL_SHADER_STORAGE_BLOCK, "MaterialHandles");
+        if (block != GL_INVALID_INDEX)
+            glShaderStorageBlockBinding(shadowBindlessShader.ID, block, 0);
+    }
+    Shader &materialShader = useBindless ? shadowBindlessShader : (useTextureArray ? shadowArrayShader : shadowShader);
     Shader lampShader("shaders/shader_lighter.vs", "shaders/shader_lighter.fs");
-    Shader textShader("shaders/shader_fonts.vs", "shaders/shader_fonts.fs");
+    Shader textShader("shaders/shader_fonts.vs", useSDFText ? "shaders/shader_fonts_sdf.fs" : "shaders/shader_fonts.fs");
+    Shader textInstancedShader("shaders/shader_fonts_instanced.vs", useSDFText ? "shaders/shader_fonts_sdf.fs" : "shaders/shader_fonts.fs");
 
     // 3. 顶点设置
     setVertices();
@@ -123,38 +198,36 @@ int main(int argc, const char * argv[]) {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         
         // 6.8 物体渲染
-        processObjectInLoop(shadowShader, lightSpaceMatrix);
+        processObjectInLoop(materialShader, lightSpaceMatrix);
         
         // 6.9. 渲染光源
         renderLightSource(lampShader);
         
         // 6.10. 渲染字体(字体位置不能超出window的宽高)
-        renderText(textShader, "Press <ctrl> to call out Mouse", 840.0f, 25.0f, 0.5f, glm::vec3(1.0, 1.0, 1.0));
-        renderText(textShader, "Press <ESC> to exit this Demo", 840.0f, 75.0f, 0.5f, glm::vec3(1.0, 1.0, 1.0));
-        renderText(textShader, "Press <W><A><S><D> to move out camera", 840.0f, 50.0f, 0.5f, glm::vec3(1.0, 1.0, 1.0));
-        renderText(textShader, "FPS: " + to_string(frame), 25.0f, 25.0f, 0.5f, glm::vec3(1.0, 1.0, 1.0));
-        renderText(textShader, "Camera position: (" +
-                   to_string(camera.camPos.x).substr(0, to_string(camera.camPos.x).find(".")+3).append(",") +
-                   to_string(camera.camPos.y).substr(0, to_string(camera.camPos.y).find(".")+3).append(",") +
-                   to_string(camera.camPos.z).substr(0, to_string(camera.camPos.z).find(".")+3).append(")"),
-                   10.0f, 705.0f, 0.3f, glm::vec3(1.0, 1.0, 1.0));
+        renderHUD(textShader, textInstancedShader);
         
         glfwSwapBuffers(window); // 颜色缓冲交换
         glfwPollEvents(); // 处理事件
     }
     // 7. 释放
-    glDeleteVertexArrays(1, &cube_VAO);
-    glDeleteVertexArrays(1, &lighterVAO);
-    glDeleteVertexArrays(1, &Fl_VAO);
-    glDeleteVertexArrays(1, &sphereVAO);
-    glDeleteVertexArrays(1, &TextVAO);
-    glDeleteBuffers(1, &cube_VBO);
-    glDeleteBuffers(1, &sphereVBO);
-    glDeleteBuffers(1, &Text_VBO);
-    glDeleteBuffers(1, &Fl_VBO);
-    glDeleteBuffers(1, &sphereEBO);
+    sphereLOD.release();
+    staticGeometry.release();
+    modelLoader.release();
+    modelGeometry.release();
+    meshCache.release();
+    materialArray.release();
+    materialTable.release();
+    textBatch.release();
+    helpLayout.release();
+    instancedBatch.release();
+    fontsManager.saveCache(font_cache);
+    fontsManager.release();
+    textureRegistry.clear();
+    glDeleteTextures(1, &depthMap);
+    glDeleteFramebuffers(1, &depthMapFBO);
 
     glfwTerminate();
+    AssetPack::unmount();
     return 0;
 }
 
@@ -165,7 +238,8 @@ void processShadowInLoop(Shader &shader, glm::mat4 lightSpaceMatrix){
     glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
     glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
     glClear(GL_DEPTH_BUFFER_BIT);
-    renderScene(shader);
+    // 阴影 pass 按光源剔除 meshlet
+    renderScene(shader, lightSpaceMatrix);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
@@ -182,11 +256,13 @@ void processObjectInLoop(Shader &shader, glm::mat4 lightSpaceMatrix){
     shader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
     shader.setInt1("diffuseTexture", 0);
     shader.setInt1("shadowMap", 1);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, floorTextureID);
+    if (useBindless)
+        materialTable.bind(0);
+    else if (useTextureArray)
+        materialArray.bind(GL_TEXTURE0);
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, depthMap);
-    renderScene(shader);
+    renderScene(shader, projection * view);
 }
 
 void renderLightSource(Shader &shader){
@@ -202,44 +278,57 @@ void renderLightSource(Shader &shader){
     shader.setMat4("projection", projection);
     shader.setInt1("diffuseTexture", 0.0);
     // 绘制光源
-    glBindVertexArray(sphereVAO);
+    sunLOD = sphereLOD.select(sphereLOD.projectedRadius(model, view, projection, (float)window_height), sunLOD);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, sunTextureID);
-    glDrawElements(GL_TRIANGLES, (int)sphere_indices.size(), GL_UNSIGNED_INT, (void*)0);
+    staticGeometry.bind();
+    sphereLOD.drawCulled(sunLOD, projection * view * model);
+    glBindVertexArray(0);
 }
 
-void renderScene(Shader &shader){
+void renderScene(Shader &shader, const glm::mat4 &viewProjection){
     // 渲染地板
     shader.use();
     glm::mat4 model = glm::mat4(1.0f);
     shader.setMat4("model", model);
-    glBindVertexArray(Fl_VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    staticGeometry.bind();
+    bindMaterial(floorTextureID, floorMaterial);
+    staticGeometry.draw(floorRange);
     
     // 渲染箱子物体
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(0.2f, 0.0f, 0.2));
     shader.setMat4("model", model);
-    glBindVertexArray(cube_VAO);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, boxTextureID);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    bindMaterial(boxTextureID, boxMaterial);
+    staticGeometry.draw(cubeRange);
     
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.4));
     shader.setMat4("model", model);
-    glBindVertexArray(cube_VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    staticGeometry.draw(cubeRange);
     
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(-1.0f, -0.12f, 2.0));
     model = glm::scale(model, glm::vec3(0.75f));
     shader.setMat4("model", model);
-    glBindVertexArray(cube_VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    staticGeometry.draw(cubeRange);
+
+    // 绘制模型: 缩放到最长边为 1, 放在地板上
+    if (modelLoader.state() == MESH_LOAD_READY) {
+        const float *lo = modelLoader.boundsMin(), *hi = modelLoader.boundsMax();
+        float extent = max(hi[0] - lo[0], max(hi[1] - lo[1], hi[2] - lo[2]));
+        float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+        model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(-2.0f, -0.5f, -1.0f));
+        model = glm::scale(model, glm::vec3(scale));
+        model = glm::translate(model, glm::vec3(-(lo[0] + hi[0]) * 0.5f, -lo[1], -(lo[2] + hi[2]) * 0.5f));
+        shader.setMat4("model", model);
+        MeshletCuller culler;
+        culler.setup(viewProjection * model);
+        modelGeometry.bind();
+        modelGeometry.drawCulled(modelLoader.range(), modelLoader.meshlets(), culler);
+        staticGeometry.bind();
+    }
 
     // 绘制球体
     model = glm::mat4(1.0f);
@@ -253,50 +342,71 @@ void renderScene(Shader &shader){
     shader.setMat4("model", model);
     shader.setMat4("view", view);
     shader.setMat4("projection", projection);
-    glBindVertexArray(sphereVAO);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, moonTextureID);
-    glDrawElements(GL_TRIANGLES, (int)sphere_indices.size(), GL_UNSIGNED_INT, (void*)0);
+    // 阴影 pass 与主 pass 都按相机选择级别, 两次结果相同
+    moonLOD = sphereLOD.select(sphereLOD.projectedRadius(model, view, projection, (float)window_height), moonLOD);
+    bindMaterial(moonTextureID, moonMaterial);
+    sphereLOD.drawCulled(moonLOD, viewProjection * model);
+    glBindVertexArray(0);
 }
 
-void renderText(Shader &shader, string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color){
-    
-    shader.use();
+void bindMaterial(GLuint textureID, int material){
+    if (useBindless) {
+        // 保证句柄常驻, 着色器通过顶点属性3的材质ID在SSBO中取句柄
+        materialTable.request(material);
+        glVertexAttrib1f(3, (float)material);
+    }else if (useTextureArray) {
+        // 纹理数组已在 pass 开始时绑定, 这里只需设置顶点属性3(当前绘制的层索引)
+        glVertexAttrib1f(3, (float)material);
+    }else{
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+    }
+}
+
+void renderHUD(Shader &shader, Shader &instancedShader){
     glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(window_width), 0.0f, static_cast<GLfloat>(window_height));
-    shader.setMat4("projection", projection);
-    shader.setFloat3("textColor", color.x, color.y, color.z);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(TextVAO);
-    
-    string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++) {
-        FontsManager::Character ch = fontsManager.Characters[*c];
-        float xPos = x + ch.Bearing.x * scale;
-        float yPos = y - (ch.size.y - ch.Bearing.y) * scale;
-        
-        float w = ch.size.x * scale;
-        float h = ch.size.y * scale;
-        
-        float vertices[6][4] = {
-            { xPos,     yPos + h,   0.0, 0.0 },
-            { xPos,     yPos,       0.0, 1.0 },
-            { xPos + w, yPos,       1.0, 1.0 },
-            
-            { xPos,     yPos + h,   0.0, 0.0 },
-            { xPos + w, yPos,       1.0, 1.0 },
-            { xPos + w, yPos + h,   1.0, 0.0 }
-        };
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        glBindBuffer(GL_ARRAY_BUFFER, Text_VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        
-        // 绘制四边形
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        x += (ch.Advance >> 6) * scale;
+    if (useSDFText) {
+        shader.use();
+        shader.setFloat1("outlineWidth", 0.1f);
+        shader.setVec3("outlineColor", glm::vec3(0.0f));
+        instancedShader.use();
+        instancedShader.setFloat1("outlineWidth", 0.1f);
+        instancedShader.setVec3("outlineColor", glm::vec3(0.0f));
+    }
+    // 静态提示: 内容不变时直接绘制缓存的顶点
+    helpLayout.begin();
+    helpLayout.addText(fontsManager, "Press <ctrl> to call out Mouse", 840.0f, 25.0f, 0.5f, glm::vec3(1.0, 1.0, 1.0));
+    helpLayout.addText(fontsManager, "Press <ESC> to exit this Demo", 840.0f, 75.0f, 0.5f, glm::vec3(1.0, 1.0, 1.0));
+    helpLayout.addText(fontsManager, "Press <W><A><S><D> to move out camera", 840.0f, 50.0f, 0.5f, glm::vec3(1.0, 1.0, 1.0));
+    helpLayout.draw(shader, projection);
+
+    // 每帧可能变化的文字: 一次上传, 一次绘制
+    if (fpsField.update(frame)) {
+        fpsText.clear();
+        fpsText.append("FPS: ").appendInt(frame);
+    }
+    // 用 | 而不是 ||, 三个字段都要更新
+    if (cameraXField.update(camera.camPos.x) | cameraYField.update(camera.camPos.y) | cameraZField.update(camera.camPos.z)) {
+        cameraText.clear();
+        cameraText.append("Camera position: (");
+        cameraXField.appendTo(cameraText);
+        cameraText.append(",");
+        cameraYField.appendTo(cameraText);
+        cameraText.append(",");
+        cameraZField.appendTo(cameraText);
+        cameraText.append(")");
+    }
+    if (useInstancedText) {
+        instancedBatch.begin();
+        instancedBatch.addText(fontsManager, fpsText.c_str(), fpsText.size(), 25.0f, 25.0f, 0.5f, glm::vec3(1.0, 1.0, 1.0));
+        instancedBatch.addText(fontsManager, cameraText.c_str(), cameraText.size(), 10.0f, 705.0f, 0.3f, glm::vec3(1.0, 1.0, 1.0));
+        instancedBatch.flush(instancedShader, projection);
+    }else{
+        textBatch.begin();
+        textBatch.addText(fontsManager, fpsText.c_str(), fpsText.size(), 25.0f, 25.0f, 0.5f, glm::vec3(1.0, 1.0, 1.0));
+        textBatch.addText(fontsManager, cameraText.c_str(), cameraText.size(), 10.0f, 705.0f, 0.3f, glm::vec3(1.0, 1.0, 1.0));
+        textBatch.flush(shader, projection);
     }
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 
@@ -331,8 +441,24 @@ int init(){
         cout << "Failed init Glew." << endl;
         return -1;
     }
+    // 不支持 bindless 纹理时退回到纹理数组
+    if (useBindless && !BindlessTextureTable::isSupported()) {
+        cout << "ARB_bindless_texture is not supported, fall back to texture array." << endl;
+        useBindless = false;
+        useTextureArray = true;
+    }
     // 处理字体
+    fontsManager.sdf = useSDFText;
     fontsManager.load_fonts(font_roman);
+    if (fontsManager.loadCache(font_cache)) {
+        cout << "Loaded glyph cache " << font_cache << " (" << fontsManager.glyphCount() << " glyphs)" << endl;
+    }else{
+        // 没有缓存时多线程预先光栅化可打印的 ASCII 字符
+        vector<uint32_t> ascii;
+        for (uint32_t c = 32; c < 127; c++)
+            ascii.push_back(c);
+        fontsManager.preload(ascii);
+    }
     glEnable(GL_BLEND);
     glEnable(GL_CULL_FACE);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -345,77 +471,64 @@ int init(){
 }
 
 void setVertices(){
-    // 球体
-    Sphere sphere(0.5f, 60, 60);
-    vector<float> sphere_vertices = sphere.getVertices();
-    sphere_indices = sphere.getIndices();
+    // 生成的网格缓存到磁盘, 之后启动直接 mmap
+    meshCache.setDirectory(mesh_cache);
     
+    // 顶点压缩: 八面体法线 + half 位置(物体尺寸都不大) + half 纹理坐标(地板重复贴图、测地线球接缝都超出 [0,1]);
+    // 每个网格的顶点数都不超过 65535, 索引用 16 位
+    staticGeometry.create(true, GL_HALF_FLOAT, GL_UNSIGNED_SHORT);
+
     // =======立方体=======
-    glGenVertexArrays(1, &cube_VAO);
-    glGenBuffers(1, &cube_VBO);
+    // 36 个顶点合并成 24 个, 改为索引绘制
+    staticGeometry.addTriangles(vertices, sizeof(vertices) / (8 * sizeof(float)), 8, cubeRange);
     
-    glBindBuffer(GL_ARRAY_BUFFER, cube_VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glBindVertexArray(cube_VAO);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8*(sizeof(float)), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8*(sizeof(float)), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8*(sizeof(float)), (void*)(6 * sizeof(float)));
+    // ===== 地板 ======
+    // 地板坐标都是 0.5 的整数倍, half 可以精确表示
+    staticGeometry.addTriangles(floorVertices, sizeof(floorVertices) / (8 * sizeof(float)), 8, floorRange);
     
     // =======球体=======
-    glGenVertexArrays(1, &sphereVAO);
-    glGenBuffers(1, &sphereVBO);
-    glGenBuffers(1, &sphereEBO);
-    
-    glBindVertexArray(sphereVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
-    glBufferData(GL_ARRAY_BUFFER, sphere_vertices.size()*sizeof(float),&sphere_vertices[0], GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphere_indices.size()*sizeof(float),&sphere_indices[0], GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6*(sizeof(float)), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6*(sizeof(float)), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 6*(sizeof(float)), (void*)(6 * sizeof(float)));
+    sphereLOD.useStrips = useSphereStrips;
+    if (useIcosphere)
+        sphereLOD.createIcosphere(staticGeometry, meshCache, 0.5f, ICOSPHERE_LOD_SUBDIVISIONS, sizeof(ICOSPHERE_LOD_SUBDIVISIONS) / sizeof(ICOSPHERE_LOD_SUBDIVISIONS[0]));
+    else
+        sphereLOD.create(staticGeometry, meshCache, 0.5f, SPHERE_LOD_SEGMENTS, sizeof(SPHERE_LOD_SEGMENTS) / sizeof(SPHERE_LOD_SEGMENTS[0]));
     
-    // ===== 地板的顶点设置======
-    glGenVertexArrays(1, &Fl_VAO);
-    glGenBuffers(1, &Fl_VBO);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, Fl_VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(floorVertices), floorVertices, GL_STATIC_DRAW);
-    glBindVertexArray(Fl_VAO);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)(3*sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)(6*sizeof(float)));
-    glBindVertexArray(0);
-    
-    // =======字体四边形的顶点设置======
-    glGenVertexArrays(1, &TextVAO);
-    glGenBuffers(1, &Text_VBO);
+    // =======模型=======
+    // 只启动后台解析, 上传在帧循环中进行
+    if (model_file[0] != '\0') {
+        modelGeometry.create(false, GL_HALF_FLOAT, GL_UNSIGNED_INT);
+        modelLoader.start(model_file, modelGeometry);
+    }
     
-    glBindVertexArray(TextVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, Text_VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4*sizeof(GLfloat), (void*)0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    // =======字体批处理缓冲======
+    textBatch.create();
+    helpLayout.create();
+    instancedBatch.create();
 }
 
 
 void setTextures(){
     // ===纹理加载=====
-    floorTextureID = loadTexture(texture_floor);
-    sunTextureID = loadTexture(texture_sun);
-    boxTextureID = loadTexture(texture_box);
-    moonTextureID = loadTexture(texture_moon);
+    sunTextureID = textureRegistry.acquire(texture_sun);
+    if (useBindless) {
+        floorTextureID = textureRegistry.acquire(texture_floor);
+        boxTextureID = textureRegistry.acquire(texture_box);
+        moonTextureID = textureRegistry.acquire(texture_moon);
+        materialTable.setBudget(TEXTURE_BUDGET);
+        floorMaterial = materialTable.add(floorTextureID);
+        boxMaterial = materialTable.add(boxTextureID);
+        moonMaterial = materialTable.add(moonTextureID);
+    }else if (useTextureArray) {
+        materialArray.create(MATERIAL_SIZE, MATERIAL_SIZE, MATERIAL_LAYERS);
+        floorMaterial = materialArray.addLayer(texture_floor);
+        boxMaterial = materialArray.addLayer(texture_box);
+        moonMaterial = materialArray.addLayer(texture_moon);
+        materialArray.generateMipmap();
+    }else{
+        floorTextureID = textureRegistry.acquire(texture_floor);
+        boxTextureID = textureRegistry.acquire(texture_box);
+        moonTextureID = textureRegistry.acquire(texture_moon);
+    }
 }
 
 void setShadows(){
@@ -444,6 +557,11 @@ void calculateInLoop(){
     float current = glfwGetTime();
     deltaTime = current - lastTime;
     lastTime = current;
+    if (useBindless)
+        materialTable.beginFrame();
+    fontsManager.beginFrame();
+    // 模型解析完成后分批上传, 每帧最多 4MB
+    modelLoader.update(modelGeometry);
     
     // 计算FPS
     double currentTime = glfwGetTime();
@@ -0,0 +1,9 @@
+// 八面体编码的法线(snorm16 x2)还原为单位向量.
+// 由 Shader 在加载时展开到各顶点着色器的 #include 处; 与 vertexFormat.cpp 中的 octDecode 保持一致
+vec3 octDecode(vec2 e){
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
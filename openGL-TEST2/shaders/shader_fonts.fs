@@ -0,0 +1,11 @@
+#version 330 core
+in vec2 TexCoords;
+in vec4 TextColor;
+out vec4 color;
+
+uniform sampler2D text;     // 字形图集, 只有红色通道
+
+void main(){
+    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
+    color = TextColor * sampled;
+}
@@ -0,0 +1,14 @@
+#version 330 core
+layout (location=0) in vec4 vertex; // <vec2 pos, vec2 tex>
+layout (location=1) in vec4 aColor; // 每个顶点的文字颜色
+
+uniform mat4 projection;
+
+out vec2 TexCoords;
+out vec4 TextColor;
+
+void main(){
+    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+    TexCoords = vertex.zw;
+    TextColor = aColor;
+}
@@ -0,0 +1,23 @@
+#version 330 core
+layout (location=0) in vec2 aPos;       // 实例: 基线起点
+layout (location=1) in uvec2 aGlyph;    // 实例: x 为字形编号, y 为缩放(1/1024 定点)
+layout (location=2) in vec4 aColor;     // 实例: 文字颜色
+
+uniform mat4 projection;
+uniform samplerBuffer glyphMetrics;     // 每个字形两个 texel: (左下角偏移, 尺寸), (uvMin, uvMax)
+
+out vec2 TexCoords;
+out vec4 TextColor;
+
+void main(){
+    vec4 rect = texelFetch(glyphMetrics, int(aGlyph.x) * 2);
+    vec4 uv = texelFetch(glyphMetrics, int(aGlyph.x) * 2 + 1);
+    float scale = float(aGlyph.y) / 1024.0;
+    // 三角形带的四个角: 左下、右下、左上、右上
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vec2 pos = aPos + (rect.xy + corner * rect.zw) * scale;
+    gl_Position = projection * vec4(pos, 0.0, 1.0);
+    // 图集的 v 轴向下, uvMin.y 是字形顶部
+    TexCoords = vec2(mix(uv.x, uv.z, corner.x), mix(uv.w, uv.y, corner.y));
+    TextColor = aColor;
+}
@@ -0,0 +1,19 @@
+#version 330 core
+in vec2 TexCoords;
+in vec4 TextColor;
+out vec4 color;
+
+uniform sampler2D text;         // 字形距离场图集, 0.5 为字形边缘
+uniform float outlineWidth;     // 描边宽度(距离场单位, 0 表示不描边)
+uniform vec3 outlineColor;
+
+void main(){
+    float dist = texture(text, TexCoords).r;
+    // 按屏幕空间导数抗锯齿, 任意缩放下边缘都保持约1像素宽
+    float smoothing = fwidth(dist) * 0.75;
+    float fill = smoothstep(0.5 - smoothing, 0.5 + smoothing, dist);
+    float edge = 0.5 - outlineWidth;
+    float alpha = smoothstep(edge - smoothing, edge + smoothing, dist);
+    vec3 rgb = mix(outlineColor, TextColor.rgb, fill);
+    color = vec4(rgb, TextColor.a * alpha);
+}
@@ -1,6 +1,6 @@
 #version 330 core
 layout (location=0) in vec3 aPos;
-layout (location=1) in vec3 aNormal;
+layout (location=1) in vec2 aNormal; // 八面体编码的法线(这里不用)
 layout (location=2) in vec2 aTexCoords;
 
 uniform mat4 model;
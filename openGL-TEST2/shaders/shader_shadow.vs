@@ -1,6 +1,6 @@
 #version 330 core
 layout (location=0) in vec3 aPos;
-layout (location=1) in vec3 aNormal;
+layout (location=1) in vec2 aNormal; // 八面体编码的法线
 layout (location=2) in vec2 aTexCoords;
 
 uniform mat4 model;
@@ -17,9 +17,11 @@ out VS_OUT {
     vec4 FragPosLightSpace;
 } vs_out;
 
+#include "octDecode.glsl"
+
 void main(){
     vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
-    vs_out.Normal = transpose(inverse(mat3(model))) * aNormal;
+    vs_out.Normal = transpose(inverse(mat3(model))) * octDecode(aNormal);
     vs_out.TexCoords = aTexCoords;
     vs_out.FragPosLightSpace = lightSpaceMatrix * vec4(vs_out.FragPos, 1.0);
     gl_Position = projection * view * model * vec4(aPos, 1.0);
@@ -0,0 +1,63 @@
+#version 330 core
+out vec4 FragColor;
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec3 TexCoords;
+    vec4 FragPosLightSpace;
+} fs_in;
+
+uniform sampler2DArray diffuseTexture;
+uniform sampler2D shadowMap;
+
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+uniform vec3 lightColor;
+
+float ShadowCalculation(vec4 fragPosLightSpace, float bias){
+    // 透视除法
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    projCoords = projCoords * 0.5 + 0.5;
+    float closestDepth = texture(shadowMap, projCoords.xy).r;  // 计算最近的深度
+    float currentDepth = projCoords.z;  // 当前深度
+    
+    float shadow;
+    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+    for (int x = -1; x <= 1 ; x++) {
+        for (int y = -1; y <= 1; y++) {
+            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r;
+            shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;  // 对比是否在阴影中
+        }
+    }
+    shadow /= 9.0;
+    if (projCoords.z > 1.0) shadow = 0.0;
+    return shadow;
+}
+
+void main(){
+    
+    vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
+    vec3 normal = normalize(fs_in.Normal);
+    
+    vec3 ambient = 0.15 * color;
+    
+    vec3 lightDir = normalize(lightPos - fs_in.FragPos);
+    float diff = max(dot(lightDir, normal), 0.0);
+    vec3 diffuse = diff * lightColor;
+    
+    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+//    vec3 reflectDir = reflect(-lightDir, normal); // 冯氏光照计算
+    float spec = 0.0;
+    vec3 halfwayDir = normalize(lightDir + viewDir); // binn-冯氏光照计算
+    spec = pow(max(dot(normal, halfwayDir), 0.0), 64.0);
+    vec3 specular = spec * lightColor;
+    
+    // 计算阴影
+//    float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);
+    float bias = 0.005;
+    float shadow = ShadowCalculation(fs_in.FragPosLightSpace, bias);
+    vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular))*color;
+    
+    FragColor = vec4(lighting, 1.0f);
+}
@@ -0,0 +1,27 @@
+#version 330 core
+layout (location=0) in vec3 aPos;
+layout (location=1) in vec2 aNormal; // 八面体编码的法线
+layout (location=2) in vec2 aTexCoords;
+layout (location=3) in float aLayer; // 材质所在的纹理数组层(每次绘制或每个实例设置)
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 lightSpaceMatrix;
+
+out VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec3 TexCoords;
+    vec4 FragPosLightSpace;
+} vs_out;
+
+#include "octDecode.glsl"
+
+void main(){
+    vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
+    vs_out.Normal = transpose(inverse(mat3(model))) * octDecode(aNormal);
+    vs_out.TexCoords = vec3(aTexCoords, aLayer);
+    vs_out.FragPosLightSpace = lightSpaceMatrix * vec4(vs_out.FragPos, 1.0);
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,29 @@
+#version 330 core
+layout (location=0) in vec3 aPos;
+layout (location=1) in vec2 aNormal; // 八面体编码的法线
+layout (location=2) in vec2 aTexCoords;
+layout (location=3) in float aMaterial; // 材质ID, 对应句柄表的下标
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 lightSpaceMatrix;
+
+out VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    vec4 FragPosLightSpace;
+} vs_out;
+flat out int Material;
+
+#include "octDecode.glsl"
+
+void main(){
+    vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
+    vs_out.Normal = transpose(inverse(mat3(model))) * octDecode(aNormal);
+    vs_out.TexCoords = aTexCoords;
+    Material = int(aMaterial + 0.5);
+    vs_out.FragPosLightSpace = lightSpaceMatrix * vec4(vs_out.FragPos, 1.0);
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
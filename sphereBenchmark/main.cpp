@@ -0,0 +1,350 @@
+//
+//  main.cpp
+//  sphereBenchmark
+//
+//  Created by Lax Zhang on 2019/3/29.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+//  球体网格对比: UV 球(sectors 段, stacks = sectors/2)与测地线球(正二十面体细分)
+//  的顶点数、三角形数、轮廓误差(三角形到球面的最大/平均径向距离, 相对半径)、
+//  三角形面积的最大/最小比(越接近 1 分布越均匀)和生成时间.
+//  第二张表是索引优化(meshOptimizer)前后的 ACMR/ATVR(16 项 FIFO 缓存模拟)与优化耗时,
+//  以及 32 位三角形列表、16 位三角形列表、16 位三角形带(图元重启)的索引字节数和三角形带的 ACMR.
+//  第三张表是按 SphereLOD 的方式切分的 meshlet(每簇最多 64 个顶点、124 个三角形)的个数和平均大小,
+//  以及从 14 个方向(坐标轴和对角线, 距球心 3 倍半径)看过去时被剔除(背面或视锥外)的簇的比例, 分透视和正交两种投影.
+//  第四张表对每级测地线球找出误差不超过它的最粗 UV 球, 比较两者的三角形数.
+//  最后一张表是高分辨率 UV 球(sectors = stacks = resolution)在不同线程数下的生成时间,
+//  threads 为 ref 的一行是原来逐顶点调用 sin/cos、push_back 的写法, 作为对照.
+//  只用到CPU, 不需要GL上下文.
+//  用法:
+//      sphereBenchmark [-segments 8,16,32,64,128,256] [-subdivisions 0,1,2,3,4,5,6] [-repeat 5]
+//                      [-resolutions 256,512,1024,2048] [-threads 1,2,4,8]
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../openGL-TEST2/header/sphere/sphere.hpp"
+#include "../openGL-TEST2/header/sphere/icosphere.hpp"
+#include "../openGL-TEST2/header/mesh/meshOptimizer.hpp"
+#include "../openGL-TEST2/header/mesh/meshlet.hpp"
+
+using namespace std;
+
+struct Options{
+    vector<int> segments;
+    vector<int> subdivisions;
+    vector<int> resolutions;
+    vector<int> threads;
+    int repeat;
+};
+
+struct Result{
+    size_t vertices;
+    size_t triangles;
+    float maxError;     // 相对半径
+    float meanError;
+    float areaRatio;    // 最大/最小三角形面积
+    double buildMs;
+    VertexCacheStats before, after, strip;
+    double optimizeMs;
+    size_t listBytes32, listBytes16, stripBytes;
+    size_t meshlets;
+    double meshletVertices, meshletTriangles;  // 每簇平均
+    double perspectiveCulled, orthoCulled;      // 被剔除的簇的比例
+};
+
+// 搜索匹配的 UV 球时的分段上限
+const int MAX_MATCH_SEGMENTS = 1024;
+
+// 从坐标轴和对角线方向看球时被剔除的簇的平均比例
+static double culledFraction(const vector<Meshlet> &meshlets, bool orthographic){
+    glm::mat4 projection = orthographic ? glm::ortho(-1.5f, 1.5f, -1.5f, 1.5f, 0.1f, 10.0f) : glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 10.0f);
+    size_t culled = 0, total = 0;
+    for (int x = -1; x <= 1; x++) {
+        for (int y = -1; y <= 1; y++) {
+            for (int z = -1; z <= 1; z++) {
+                int axes = (x != 0) + (y != 0) + (z != 0);
+                if (axes != 1 && axes != 3)
+                    continue;
+                glm::vec3 eye = glm::normalize(glm::vec3(x, y, z)) * 3.0f;
+                glm::vec3 up = x == 0 && z == 0 ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+                MeshletCuller culler;
+                culler.setup(projection * glm::lookAt(eye, glm::vec3(0.0f), up));
+                for (size_t i = 0; i < meshlets.size(); i++)
+                    culled += !culler.visible(meshlets[i]);
+                total += meshlets.size();
+            }
+        }
+    }
+    return total > 0 ? (double)culled / total : 0.0;
+}
+
+static vector<int> parseInts(const char *text){
+    vector<int> values;
+    for (const char *c = text; *c != '\0';) {
+        values.push_back(atoi(c));
+        const char *comma = strchr(c, ',');
+        if (comma == NULL)
+            break;
+        c = comma + 1;
+    }
+    return values;
+}
+
+static bool parseOptions(int argc, const char *argv[], Options &options){
+    options.segments = parseInts("8,16,32,64,128,256");
+    options.subdivisions = parseInts("0,1,2,3,4,5,6");
+    options.resolutions = parseInts("256,512,1024,2048");
+    options.threads = parseInts("1,2,4,8");
+    options.repeat = 5;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            cout << "ERROR::SPHERE_BENCHMARK: Missing value for " << arg << endl;
+            return false;
+        }
+        const char *value = argv[++i];
+        if (arg == "-segments")
+            options.segments = parseInts(value);
+        else if (arg == "-subdivisions")
+            options.subdivisions = parseInts(value);
+        else if (arg == "-resolutions")
+            options.resolutions = parseInts(value);
+        else if (arg == "-threads")
+            options.threads = parseInts(value);
+        else if (arg == "-repeat")
+            options.repeat = max(1, atoi(value));
+        else {
+            cout << "ERROR::SPHERE_BENCHMARK: Unknown option " << arg << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static float areaRatio(const vector<float> &vertices, const vector<unsigned int> &indices){
+    float minArea = FLT_MAX, maxArea = 0.0f;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const float *a = &vertices[indices[i] * 8], *b = &vertices[indices[i + 1] * 8], *c = &vertices[indices[i + 2] * 8];
+        float ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+        float ac[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+        float nx = ab[1] * ac[2] - ab[2] * ac[1], ny = ab[2] * ac[0] - ab[0] * ac[2], nz = ab[0] * ac[1] - ab[1] * ac[0];
+        float area = sqrtf(nx * nx + ny * ny + nz * nz);
+        minArea = fminf(minArea, area);
+        maxArea = fmaxf(maxArea, area);
+    }
+    return minArea > 0.0f ? maxArea / minArea : 0.0f;
+}
+
+template <typename Mesh>
+static void measure(const Mesh &mesh, Result &result){
+    const vector<float> &vertices = mesh.getVertices();
+    const vector<unsigned int> &indices = mesh.getIndices();
+    result.vertices = vertices.size() / 8;
+    result.triangles = indices.size() / 3;
+    result.maxError = sphereSurfaceError(&vertices[0], 8, &indices[0], indices.size(), 1.0f, &result.meanError);
+    result.areaRatio = areaRatio(vertices, indices);
+
+    // 与 MeshCache 相同的优化顺序
+    vector<float> optimizedVertices(vertices);
+    vector<unsigned int> optimizedIndices(indices);
+    size_t vertexCount = result.vertices;
+    result.before = analyzeVertexCache(&indices[0], indices.size(), vertexCount);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    optimizeVertexCache(&optimizedIndices[0], optimizedIndices.size(), vertexCount);
+    optimizeOverdraw(&optimizedIndices[0], optimizedIndices.size(), &optimizedVertices[0], vertexCount, 8);
+    vertexCount = optimizeVertexFetch(&optimizedVertices[0], vertexCount, 8, &optimizedIndices[0], optimizedIndices.size());
+    result.optimizeMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    result.after = analyzeVertexCache(&optimizedIndices[0], optimizedIndices.size(), vertexCount);
+
+    // 与 SphereLOD 相同: 顶点数放得下时用 16 位索引, 三角形带要留出 0xFFFF 作重启标记
+    vector<unsigned int> strips, stripTriangles;
+    stripify(&optimizedIndices[0], optimizedIndices.size(), strips);
+    unstripify(&strips[0], strips.size(), stripTriangles);
+    result.strip = analyzeVertexCache(&stripTriangles[0], stripTriangles.size(), vertexCount);
+    result.listBytes32 = optimizedIndices.size() * 4;
+    result.listBytes16 = optimizedIndices.size() * (vertexCount <= 0x10000 ? 2 : 4);
+    result.stripBytes = strips.size() * (vertexCount <= 0xFFFF ? 2 : 4);
+
+    vector<Meshlet> meshlets;
+    buildMeshlets(&optimizedIndices[0], optimizedIndices.size(), &optimizedVertices[0], vertexCount, 8, meshlets);
+    size_t meshletVertices = 0;
+    for (size_t i = 0; i < meshlets.size(); i++)
+        meshletVertices += meshlets[i].vertexCount;
+    result.meshlets = meshlets.size();
+    result.meshletVertices = (double)meshletVertices / meshlets.size();
+    result.meshletTriangles = (double)result.triangles / meshlets.size();
+    result.perspectiveCulled = culledFraction(meshlets, false);
+    result.orthoCulled = culledFraction(meshlets, true);
+}
+
+static Result runSphere(int segments, int repeat){
+    Result result;
+    Sphere sphere;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < repeat; i++)
+        sphere.set(1.0f, segments, max(2, segments / 2));
+    result.buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / repeat;
+    measure(sphere, result);
+    return result;
+}
+
+static Result runIcosphere(int subdivisions, int repeat){
+    Result result;
+    Icosphere icosphere(1.0f, 0);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < repeat; i++)
+        icosphere.set(1.0f, subdivisions);
+    result.buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / repeat;
+    measure(icosphere, result);
+    return result;
+}
+
+static void printResult(const char *kind, int level, const Result &result){
+    printf("%-10s %6d %9zu %10zu %12.3e %12.3e %12.2f %10.3f\n", kind, level, result.vertices, result.triangles,
+           result.maxError, result.meanError, result.areaRatio, result.buildMs);
+}
+
+static void printCacheStats(const char *kind, int level, const Result &result){
+    printf("%-10s %6d %10.3f %10.3f %10.3f %10.3f %12.3f %10zu %10zu %10zu %10.3f\n", kind, level, result.before.acmr, result.after.acmr,
+           result.before.atvr, result.after.atvr, result.optimizeMs, result.listBytes32, result.listBytes16, result.stripBytes, result.strip.acmr);
+}
+
+static void printMeshlets(const char *kind, int level, const Result &result){
+    printf("%-10s %6d %10zu %12.1f %12.1f %12.1f %12.1f\n", kind, level, result.meshlets, result.meshletVertices, result.meshletTriangles,
+           result.perspectiveCulled * 100.0, result.orthoCulled * 100.0);
+}
+
+// 误差不超过 maxError 的最粗 UV 球(分段数取偶数); 超过上限时返回 -1
+static int matchSphere(float maxError){
+    int low = 2, high = MAX_MATCH_SEGMENTS / 2;
+    if (runSphere(high * 2, 1).maxError > maxError)
+        return -1;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (runSphere(middle * 2, 1).maxError <= maxError)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return low * 2;
+}
+
+// 原来的 Sphere::buildVertices/buildIndices: 浮点循环变量, 每个顶点都调用 sin/cos, 逐个 push_back
+static void legacySphere(float radius, int sectorCount, int stackCount, vector<float> &vertices, vector<unsigned int> &indices){
+    float sectorStep = (2*PI)/sectorCount;
+    float stackStep = PI/stackCount;
+    float lenInv = 1.0f / radius;
+    vertices.clear();
+    indices.clear();
+    vertices.reserve((size_t)(stackCount + 1) * (sectorCount + 1) * 8);
+    for (float i = 0; i <= stackCount; i++) {
+        float stackAngle = PI/2 - i*stackStep;
+        float z = radius * sin(stackAngle);
+        float xy = radius * cos(stackAngle);
+        for (float j = 0; j <= sectorCount; j++) {
+            float sectorAngle = sectorStep * j;
+            float x = xy * cos(sectorAngle);
+            float y = xy * sin(sectorAngle);
+            float vertex[8] = {x, y, z, x * lenInv, y * lenInv, z * lenInv, (float)j / sectorCount, (float)i / stackCount};
+            vertices.insert(vertices.end(), vertex, vertex + 8);
+        }
+    }
+    indices.reserve((size_t)sectorCount * (stackCount > 1 ? stackCount * 2 - 2 : 0) * 3);
+    for (int i = 0; i < stackCount; i++) {
+        int k1 = i * (sectorCount + 1);
+        int k2 = k1 + sectorCount + 1;
+        for (int j = 0; j < sectorCount; j++, k1++, k2++) {
+            if (i != 0) {
+                indices.push_back(k1);
+                indices.push_back(k2);
+                indices.push_back(k1+1);
+            }
+            if (i != (stackCount - 1)) {
+                indices.push_back(k1+1);
+                indices.push_back(k2);
+                indices.push_back(k2+1);
+            }
+        }
+    }
+}
+
+// threads 为 -1 时测原来的写法
+static double buildTime(int resolution, int threads, int repeat){
+    Sphere sphere(1.0f, 1, 1);
+    vector<float> vertices;
+    vector<unsigned int> indices;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < repeat; i++) {
+        if (threads < 0)
+            legacySphere(1.0f, resolution, resolution, vertices, indices);
+        else
+            sphere.set(1.0f, resolution, resolution, true, threads);
+    }
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / repeat;
+}
+
+int main(int argc, const char * argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options))
+        return 1;
+
+    printf("%-10s %6s %9s %10s %12s %12s %12s %10s\n", "mesh", "level", "vertices", "triangles", "max error", "mean error", "area max/min", "build ms");
+    vector<Result> spheres, icospheres;
+    for (size_t i = 0; i < options.segments.size(); i++) {
+        spheres.push_back(runSphere(options.segments[i], options.repeat));
+        printResult("uv", options.segments[i], spheres.back());
+    }
+    for (size_t i = 0; i < options.subdivisions.size(); i++) {
+        icospheres.push_back(runIcosphere(options.subdivisions[i], options.repeat));
+        printResult("icosphere", options.subdivisions[i], icospheres.back());
+    }
+
+    printf("\n%-10s %6s %10s %10s %10s %10s %12s %10s %10s %10s %10s\n", "mesh", "level", "acmr", "acmr opt", "atvr", "atvr opt", "optimize ms",
+           "list32 B", "list16 B", "strip B", "strip acmr");
+    for (size_t i = 0; i < spheres.size(); i++)
+        printCacheStats("uv", options.segments[i], spheres[i]);
+    for (size_t i = 0; i < icospheres.size(); i++)
+        printCacheStats("icosphere", options.subdivisions[i], icospheres[i]);
+
+    printf("\n%-10s %6s %10s %12s %12s %12s %12s\n", "mesh", "level", "meshlets", "verts/mlet", "tris/mlet", "persp cull %", "ortho cull %");
+    for (size_t i = 0; i < spheres.size(); i++)
+        printMeshlets("uv", options.segments[i], spheres[i]);
+    for (size_t i = 0; i < icospheres.size(); i++)
+        printMeshlets("icosphere", options.subdivisions[i], icospheres[i]);
+
+    printf("\n%-12s %10s %12s %12s %12s %10s\n", "subdivisions", "triangles", "max error", "uv segments", "uv triangles", "uv / ico");
+    for (size_t i = 0; i < icospheres.size(); i++) {
+        int segments = matchSphere(icospheres[i].maxError);
+        if (segments < 0) {
+            printf("%-12d %10zu %12.3e %12s\n", options.subdivisions[i], icospheres[i].triangles, icospheres[i].maxError, "-");
+            continue;
+        }
+        Result matched = runSphere(segments, 1);
+        printf("%-12d %10zu %12.3e %12d %12zu %10.2f\n", options.subdivisions[i], icospheres[i].triangles, icospheres[i].maxError,
+               segments, matched.triangles, (double)matched.triangles / icospheres[i].triangles);
+    }
+
+    printf("\n%-10s %8s %12s %10s %14s %10s\n", "resolution", "threads", "vertices", "build ms", "Mvertices/s", "speedup");
+    for (size_t r = 0; r < options.resolutions.size(); r++) {
+        int resolution = options.resolutions[r];
+        double vertices = (double)(resolution + 1) * (resolution + 1);
+        double legacyMs = buildTime(resolution, -1, options.repeat);
+        printf("%-10d %8s %12.0f %10.2f %14.1f %10.2f\n", resolution, "ref", vertices, legacyMs, vertices / legacyMs / 1000.0, 1.0);
+        for (size_t t = 0; t < options.threads.size(); t++) {
+            double ms = buildTime(resolution, options.threads[t], options.repeat);
+            printf("%-10d %8d %12.0f %10.2f %14.1f %10.2f\n", resolution, options.threads[t], vertices, ms, vertices / ms / 1000.0, legacyMs / ms);
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
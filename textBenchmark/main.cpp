@@ -0,0 +1,410 @@
+//
+//  main.cpp
+//  textBenchmark
+//
+//  Created by Lax Zhang on 2019/3/25.
+//  Copyright © 2019 Lax Zhang. All rights reserved.
+//
+//  文字渲染吞吐量测试: 用不同的文字量(10 ~ 100k 个字形)、静态/每帧变化的文字和几种缩放,
+//  分别测量 TextBatch、TextLayout、InstancedTextBatch 以及逐字符绘制(最初 renderText 的做法),
+//  输出每毫秒字形数、CPU 时间、GPU 时间(GL_TIME_ELAPSED)和每帧上传的字节数.
+//  窗口隐藏, 渲染到离屏 FBO, 可以在没有显示器的机器上用 llvmpipe 运行.
+//  llvmpipe 在调用线程里执行顶点着色, 光栅化也在CPU上, 计时查询几乎总是0, 这时以 frame ms 为准.
+//  用法(在 openGL-TEST2 目录下执行):
+//      textBenchmark [-path all|percharacter|batch|layout|instanced] [-mode both|static|changing]
+//                    [-glyphs 10,100,1000,10000,100000] [-scales 0.3,0.5,1.0] [-frames 60] [-sdf]
+//  Linux 上无显示器时: xvfb-run -a env LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe textBenchmark
+//
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../openGL-TEST2/header/shader/shader.hpp"
+#include "../openGL-TEST2/header/fonts/FontsManager.hpp"
+#include "../openGL-TEST2/header/fonts/textBatch.hpp"
+#include "../openGL-TEST2/header/fonts/textLayout.hpp"
+#include "../openGL-TEST2/header/fonts/instancedTextBatch.hpp"
+
+using namespace std;
+
+enum TextPath{
+    PATH_PER_CHARACTER,
+    PATH_BATCH,
+    PATH_LAYOUT,
+    PATH_INSTANCED,
+    PATH_COUNT
+};
+static const char *pathNames[PATH_COUNT] = {"percharacter", "batch", "layout", "instanced"};
+
+struct Options{
+    vector<int> paths;
+    vector<int> glyphs;
+    vector<float> scales;
+    int modes;      // 1: 静态, 2: 变化, 3: 两者
+    int frames;
+    bool sdf;
+};
+
+struct Result{
+    double cpuMs;       // 每帧提交的 CPU 时间
+    double gpuMs;       // 每帧的 GPU 时间
+    double frameMs;     // 每帧从提交到 glFinish 返回的时间
+    double bytes;       // 每帧上传的顶点/实例字节数
+    double drawCalls;
+};
+
+const int window_width = 1280;
+const int window_height = 720;
+// 每行字符数, 超出屏幕高度的行从顶部重新开始(重叠绘制)
+const int LINE_LENGTH = 100;
+const int WARMUP_FRAMES = 5;
+
+GLFWwindow *window;
+GLuint benchFBO, benchColor;
+GLuint perCharacterVAO, perCharacterVBO;
+FontsManager fontsManager;
+char font_roman[255] = "resources/fonts/Times New Roman.ttf";
+
+static vector<int> parseInts(const char *text){
+    vector<int> values;
+    for (const char *c = text; *c != '\0';) {
+        values.push_back(atoi(c));
+        const char *comma = strchr(c, ',');
+        if (comma == NULL)
+            break;
+        c = comma + 1;
+    }
+    return values;
+}
+
+static vector<float> parseFloats(const char *text){
+    vector<float> values;
+    for (const char *c = text; *c != '\0';) {
+        values.push_back((float)atof(c));
+        const char *comma = strchr(c, ',');
+        if (comma == NULL)
+            break;
+        c = comma + 1;
+    }
+    return values;
+}
+
+static bool parseOptions(int argc, const char *argv[], Options &options){
+    options.glyphs = parseInts("10,100,1000,10000,100000");
+    options.scales = parseFloats("0.3,0.5,1.0");
+    options.modes = 3;
+    options.frames = 60;
+    options.sdf = false;
+    const char *paths = "all";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-sdf") {
+            options.sdf = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cout << "ERROR::TEXT_BENCHMARK: Missing value for " << arg << endl;
+            return false;
+        }
+        const char *value = argv[++i];
+        if (arg == "-path")
+            paths = value;
+        else if (arg == "-mode")
+            options.modes = strcmp(value, "static") == 0 ? 1 : (strcmp(value, "changing") == 0 ? 2 : 3);
+        else if (arg == "-glyphs")
+            options.glyphs = parseInts(value);
+        else if (arg == "-scales")
+            options.scales = parseFloats(value);
+        else if (arg == "-frames")
+            options.frames = max(1, atoi(value));
+        else {
+            cout << "ERROR::TEXT_BENCHMARK: Unknown option " << arg << endl;
+            return false;
+        }
+    }
+    for (int p = 0; p < PATH_COUNT; p++)
+        if (strcmp(paths, "all") == 0 || strstr(paths, pathNames[p]) != NULL)
+            options.paths.push_back(p);
+    if (options.paths.empty()) {
+        cout << "ERROR::TEXT_BENCHMARK: Unknown path " << paths << endl;
+        return false;
+    }
+    return true;
+}
+
+int init(){
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    // 不显示窗口, 只借用它的GL上下文
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    window = glfwCreateWindow(64, 64, "Text Benchmark", NULL, NULL);
+    if (window == NULL) {
+        cout << "ERROR::TEXT_BENCHMARK: Failed Create Window" << endl;
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    // 关闭垂直同步, 避免帧时间被显示器刷新率限制
+    glfwSwapInterval(0);
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        cout << "ERROR::TEXT_BENCHMARK: Failed init Glew." << endl;
+        return -1;
+    }
+    cout << "GL_RENDERER: " << glGetString(GL_RENDERER) << endl;
+    cout << "GL_VERSION: " << glGetString(GL_VERSION) << endl;
+
+    // 离屏颜色缓冲, 大小与 demo 的窗口一致
+    glGenFramebuffers(1, &benchFBO);
+    glGenRenderbuffers(1, &benchColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, benchColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, window_width, window_height);
+    glBindFramebuffer(GL_FRAMEBUFFER, benchFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, benchColor);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cout << "ERROR::TEXT_BENCHMARK: Framebuffer is not complete" << endl;
+        return -1;
+    }
+    glViewport(0, 0, window_width, window_height);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // 逐字符路径: 每个字符 6 个顶点, 一次 glBufferSubData 一次 glDrawArrays
+    glGenVertexArrays(1, &perCharacterVAO);
+    glGenBuffers(1, &perCharacterVBO);
+    glBindVertexArray(perCharacterVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, perCharacterVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    return 0;
+}
+
+// 逐字符绘制, 与最初的 renderText 相同(字形改为从图集取), 返回绘制次数
+static int renderText(Shader &shader, const glm::mat4 &projection, const string &text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color){
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setInt1("text", 0);
+    // 颜色属性不开数组, 用常量值
+    glVertexAttrib4f(1, color.x, color.y, color.z, 1.0f);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(perCharacterVAO);
+
+    int drawCalls = 0;
+    for (string::const_iterator c = text.begin(); c != text.end(); c++) {
+        const FontsManager::Character *glyph = fontsManager.getGlyph((unsigned char)*c);
+        if (glyph == NULL)
+            continue;
+        const FontsManager::Character &ch = *glyph;
+        float xPos = x + ch.Bearing.x * scale;
+        float yPos = y - (ch.size.y - ch.Bearing.y) * scale;
+        float w = ch.size.x * scale;
+        float h = ch.size.y * scale;
+        x += (ch.Advance >> 6) * scale;
+        if (ch.page < 0)
+            continue;
+
+        float vertices[6][4] = {
+            { xPos,     yPos + h,   ch.uvMin.x, ch.uvMin.y },
+            { xPos,     yPos,       ch.uvMin.x, ch.uvMax.y },
+            { xPos + w, yPos,       ch.uvMax.x, ch.uvMax.y },
+
+            { xPos,     yPos + h,   ch.uvMin.x, ch.uvMin.y },
+            { xPos + w, yPos,       ch.uvMax.x, ch.uvMax.y },
+            { xPos + w, yPos + h,   ch.uvMax.x, ch.uvMin.y }
+        };
+        // 新光栅化的字形先上传
+        if (fontsManager.pages[ch.page].TextureID == 0 || fontsManager.pages[ch.page].dirty())
+            fontsManager.commit();
+        glBindTexture(GL_TEXTURE_2D, fontsManager.pages[ch.page].TextureID);
+        glBindBuffer(GL_ARRAY_BUFFER, perCharacterVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        drawCalls++;
+    }
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return drawCalls;
+}
+
+// 生成 glyphs 个可打印 ASCII 字符, 按 LINE_LENGTH 分行
+static void buildLines(int glyphs, vector<string> &lines){
+    lines.clear();
+    for (int i = 0; i < glyphs; i += LINE_LENGTH) {
+        string line;
+        int length = min(LINE_LENGTH, glyphs - i);
+        for (int j = 0; j < length; j++)
+            line.push_back((char)(33 + (i + j * 7) % 94));
+        lines.push_back(line);
+    }
+}
+
+// 变化的文字: 原地改写每行的字符(长度不变, 不分配内存)
+static void changeLines(vector<string> &lines, int frame){
+    for (size_t i = 0; i < lines.size(); i++)
+        for (size_t j = 0; j < lines[i].size(); j++)
+            lines[i][j] = (char)(33 + (i + j * 7 + frame) % 94);
+}
+
+static Result runCase(int path, const vector<string> &source, bool changing, float scale, int frames, Shader &shader, Shader &instancedShader){
+    TextBatch batch;
+    TextLayout layout;
+    InstancedTextBatch instanced;
+    if (path == PATH_BATCH)
+        batch.create();
+    else if (path == PATH_LAYOUT)
+        layout.create();
+    else if (path == PATH_INSTANCED)
+        instanced.create();
+
+    glm::mat4 projection = glm::ortho(0.0f, static_cast<GLfloat>(window_width), 0.0f, static_cast<GLfloat>(window_height));
+    vector<string> lines = source;
+    float lineHeight = fontsManager.pixelSize * scale;
+    int rows = max(1, (int)((window_height - lineHeight) / lineHeight));
+    glm::vec3 color(1.0f, 1.0f, 1.0f);
+
+    GLuint query;
+    glGenQueries(1, &query);
+    Result result = {0.0, 0.0, 0.0, 0.0, 0.0};
+    for (int frame = 0; frame < WARMUP_FRAMES + frames; frame++) {
+        if (changing)
+            changeLines(lines, frame);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glFinish();
+
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        fontsManager.beginFrame();
+        size_t bytes = 0;
+        int drawCalls = 0;
+        if (path == PATH_PER_CHARACTER) {
+            for (size_t i = 0; i < lines.size(); i++)
+                drawCalls += renderText(shader, projection, lines[i], 10.0f, window_height - lineHeight * (i % rows + 1), scale, color);
+            bytes = drawCalls * sizeof(GLfloat) * 6 * 4;
+        }else if (path == PATH_BATCH) {
+            batch.begin();
+            for (size_t i = 0; i < lines.size(); i++)
+                batch.addText(fontsManager, lines[i], 10.0f, window_height - lineHeight * (i % rows + 1), scale, color);
+            batch.flush(shader, projection);
+            bytes = batch.uploadedBytes();
+            drawCalls = batch.drawCalls();
+        }else if (path == PATH_LAYOUT) {
+            layout.begin();
+            for (size_t i = 0; i < lines.size(); i++)
+                layout.addText(fontsManager, lines[i], 10.0f, window_height - lineHeight * (i % rows + 1), scale, color);
+            layout.draw(shader, projection);
+            bytes = layout.uploadedBytes();
+            drawCalls = layout.drawCalls();
+        }else{
+            instanced.begin();
+            for (size_t i = 0; i < lines.size(); i++)
+                instanced.addText(fontsManager, lines[i], 10.0f, window_height - lineHeight * (i % rows + 1), scale, color);
+            instanced.flush(instancedShader, projection);
+            bytes = instanced.uploadedBytes();
+            drawCalls = instanced.drawCalls();
+        }
+        chrono::steady_clock::time_point submitted = chrono::steady_clock::now();
+        glEndQuery(GL_TIME_ELAPSED);
+        glFinish();
+        chrono::steady_clock::time_point finished = chrono::steady_clock::now();
+
+        GLuint64 gpuTime = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpuTime);
+        // 前几帧包含缓冲扩容与着色器首次编译, 不计入
+        if (frame < WARMUP_FRAMES)
+            continue;
+        result.cpuMs += chrono::duration<double, milli>(submitted - start).count();
+        result.frameMs += chrono::duration<double, milli>(finished - start).count();
+        result.gpuMs += gpuTime / 1.0e6;
+        result.bytes += (double)bytes;
+        result.drawCalls += drawCalls;
+    }
+    glDeleteQueries(1, &query);
+    batch.release();
+    layout.release();
+    instanced.release();
+
+    result.cpuMs /= frames;
+    result.gpuMs /= frames;
+    result.frameMs /= frames;
+    result.bytes /= frames;
+    result.drawCalls /= frames;
+    return result;
+}
+
+int main(int argc, const char * argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options))
+        return 1;
+    if (init() == -1) {
+        glfwTerminate();
+        return 1;
+    }
+
+    Shader textShader("shaders/shader_fonts.vs", options.sdf ? "shaders/shader_fonts_sdf.fs" : "shaders/shader_fonts.fs");
+    Shader textInstancedShader("shaders/shader_fonts_instanced.vs", options.sdf ? "shaders/shader_fonts_sdf.fs" : "shaders/shader_fonts.fs");
+    if (options.sdf) {
+        textShader.use();
+        textShader.setFloat1("outlineWidth", 0.0f);
+        textShader.setVec3("outlineColor", glm::vec3(0.0f));
+        textInstancedShader.use();
+        textInstancedShader.setFloat1("outlineWidth", 0.0f);
+        textInstancedShader.setVec3("outlineColor", glm::vec3(0.0f));
+    }
+
+    // 先把测试用到的字形全部光栅化, 只测量绘制
+    fontsManager.sdf = options.sdf;
+    if (fontsManager.load_fonts(font_roman) < 0) {
+        glfwTerminate();
+        return 1;
+    }
+    vector<uint32_t> ascii;
+    for (uint32_t c = 32; c < 127; c++)
+        ascii.push_back(c);
+    fontsManager.preload(ascii);
+    fontsManager.commit();
+
+    printf("%-13s %-9s %7s %6s %12s %9s %9s %9s %12s %9s\n", "path", "mode", "glyphs", "scale", "glyphs/ms", "cpu ms", "gpu ms", "frame ms", "bytes/frame", "draws");
+    vector<string> lines;
+    for (size_t g = 0; g < options.glyphs.size(); g++) {
+        buildLines(options.glyphs[g], lines);
+        for (size_t s = 0; s < options.scales.size(); s++) {
+            for (int mode = 1; mode <= 2; mode++) {
+                if ((options.modes & mode) == 0)
+                    continue;
+                for (size_t p = 0; p < options.paths.size(); p++) {
+                    int path = options.paths[p];
+                    Result result = runCase(path, lines, mode == 2, options.scales[s], options.frames, textShader, textInstancedShader);
+                    double throughput = result.frameMs > 0.0 ? options.glyphs[g] / result.frameMs : 0.0;
+                    printf("%-13s %-9s %7d %6.2f %12.1f %9.3f %9.3f %9.3f %12.0f %9.1f\n", pathNames[path], mode == 2 ? "changing" : "static",
+                           options.glyphs[g], options.scales[s], throughput, result.cpuMs, result.gpuMs, result.frameMs, result.bytes, result.drawCalls);
+                    fflush(stdout);
+                }
+            }
+        }
+    }
+
+    fontsManager.release();
+    glDeleteVertexArrays(1, &perCharacterVAO);
+    glDeleteBuffers(1, &perCharacterVBO);
+    glDeleteRenderbuffers(1, &benchColor);
+    glDeleteFramebuffers(1, &benchFBO);
+    glfwTerminate();
+    return 0;
+}